@@ -0,0 +1,503 @@
+#pragma once
+
+//
+// e̔`ɉēKIɕwi`p̃bV
+//
+
+// ɉeNX`̃^C̑I (ẽfƃeNX`W̌vZ)
+#include "ViewTiles.h"
+
+// WCu
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// wi`p̃bVWJɎgVF[_ƓvŽ덷œKIɕNX
+//   e{̊iqn߂āA_̃eNX`W̐`ԂƐeNX`W̍
+//   XN[̉fɊẐe덷𒴂iqlB
+//   ׂ荇iq̐[̍ 1 ܂łɑÅׂׂiqƐڂӂɂ͒_
+//   Op`ɕ̂ T ̌pڂ͂łȂB
+//   œ_AC[WT[NAr[|[gςƂ蒼A_obt@ɕێĕ`B
+class AdaptiveMesh
+{
+  // WJɎgVF[_̓ẽf
+  ViewTiles::Model model;
+
+  // e덷 (XN[̉f)
+  const double tolerance;
+
+  // {̊iq𕪊ő̉
+  const int levels;
+
+  // {̊iq̏c̐
+  static constexpr int baseRows = 8;
+
+  // Ăłiq̃XN[̍ŏ̉f
+  static constexpr double minimumSize = 2.0;
+
+  // ̌덷fɊZW (Ȏ͓iFȂ̂ō̍ 1/2  1 fƂ݂Ȃ)
+  static constexpr double blendScale = 2.0;
+
+  // _zIuWFNgƒ_obt@IuWFNgƃCfbNXobt@IuWFNg
+  GLuint vao, vbo, ibo;
+
+  // _ʒun_ point ̏ꏊ
+  GLint pointLoc;
+
+  // `悷钸_̐ƃCfbNX̐
+  GLsizei vertexCount, indexCount;
+
+  // bVƂ̃p[^
+  std::vector<GLfloat> key;
+
+  // bV
+  unsigned long built;
+
+  // bVƂ̎̉]sAœ_AXN[AC[WT[NAeNX`̑傫
+  double r[9];
+  double focal;
+  GLfloat screen[4], circle[4];
+  ViewTiles::Extent extent;
+
+  // bVƂ̃r[|[g̑傫
+  GLint viewport[4];
+
+  // {̊iq̐ƍłׂiq̐
+  int columns, rows;
+  int width, height;
+
+  // iq (łׂiqPʂƂ鍶̈ʒuƐ[ASɒ_uǂ)
+  struct Cell
+  {
+    int x, y, level;
+    bool center;
+  };
+  std::vector<Cell> leaves;
+
+  // łׂiqƂɂ𕢂iq̐[
+  std::vector<signed char> depth;
+
+  // _ʒuƃCfbNX
+  std::vector<GLfloat> points;
+  std::vector<GLuint> indices;
+
+  // łׂiq̔PʂƂiq_Ƃ̒_ԍ
+  std::vector<GLuint> lattice;
+
+  // Rs[RXgN^𕕂
+  AdaptiveMesh(const AdaptiveMesh &c);
+
+  // 𕕂
+  AdaptiveMesh &operator=(const AdaptiveMesh &w);
+
+  // łׂiqPʂƂʒu (x, y) ̃eNX`W߂
+  ViewTiles::Sample sample(double x, double y) const
+  {
+    // XN[̓_Ɖ]PʃxNg
+    const double p[] =
+    {
+      (x * 2.0 / width - 1.0) * screen[0] + screen[2],
+      (y * 2.0 / height - 1.0) * screen[1] + screen[3]
+    };
+    double v[3];
+    for (int k = 0; k < 3; ++k) v[k] = r[k * 3] * p[0] + r[k * 3 + 1] * p[1] - r[k * 3 + 2] * focal;
+    const double l(std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+    for (int k = 0; k < 3; ++k) v[k] /= l;
+
+    ViewTiles::Sample s;
+    s.tc[0][0] = s.tc[0][1] = s.tc[1][0] = s.tc[1][1] = 0.0;
+    ViewTiles::project(model, extent, v, p, circle, s);
+    return s;
+  }
+
+  // iq̎l̒l c[0] (), c[1] (E), c[2] (), c[3] (E) ƒS̒l c[4]  (u, v) ̒l`Ԃ
+  //   center  false Ȃ獶ƉEԑΊpŕ̎Op`A
+  //   true Ȃ璆S`ɕl̎Op`ŕԂB
+  static double interpolate(const double *c, double u, double v, bool center)
+  {
+    if (!center)
+      return u >= v ? c[0] + u * (c[1] - c[0]) + v * (c[3] - c[1]) : c[0] + u * (c[3] - c[2]) + v * (c[2] - c[0]);
+
+    // S̈ʒuƁA܂ގOp`̒SȊO̓̒_ɑ΂d
+    const double x(u - 0.5), y(v - 0.5);
+    if (x >= std::abs(y)) return c[4] + (x - y) * (c[1] - c[4]) + (x + y) * (c[3] - c[4]);
+    if (-x >= std::abs(y)) return c[4] + (-x - y) * (c[0] - c[4]) + (-x + y) * (c[2] - c[4]);
+    if (y < 0.0) return c[4] + (-y - x) * (c[0] - c[4]) + (-y + x) * (c[1] - c[4]);
+    return c[4] + (y - x) * (c[2] - c[4]) + (y + x) * (c[3] - c[4]);
+  }
+
+  // iq̒̓_̃eNX`W̐`Ԃɂ덷e덷ȓǂ
+  //   corner ͎lƒS̃eNX`WAcenter ͒Sɒ_uĕԂ邩ǂB
+  //   eNX`W̌덷͔wieNX`̉fŋ߁Aiq̕ӂ̃XN[̒
+  //   eNX`̒̔ (g嗦) ăXN[̉fɊZB
+  bool accurate(const ViewTiles::Sample *corner, bool center, int x, int y, int size) const
+  {
+    // iq̓ƕӂ̒_Œׂ
+    static const double test[][2] =
+    {
+      { 0.5, 0.0 }, { 1.0, 0.5 }, { 0.5, 1.0 }, { 0.0, 0.5 },
+      { 0.25, 0.25 }, { 0.5, 0.25 }, { 0.75, 0.25 },
+      { 0.25, 0.5 }, { 0.5, 0.5 }, { 0.75, 0.5 },
+      { 0.25, 0.75 }, { 0.5, 0.75 }, { 0.75, 0.75 }
+    };
+
+    // iq̕ӂ̃XN[̉f
+    const double sx(static_cast<double>(size) * viewport[2] / width), sy(static_cast<double>(size) * viewport[3] / height);
+
+    // ׂĂf菬Ȃ邾Ȃ番Ȃ
+    if (std::min(sx, sy) < minimumSize * 2.0) return true;
+
+    // eNX`W̑gƂɃXN[̉f̃eNX`̉f̃Rrs̋ts߂
+    double inverse[2][4];
+    for (int n = 0; n < 2; ++n)
+    {
+      const double a((corner[1].tc[n][0] - corner[0].tc[n][0]) * extent.textureWidth / sx);
+      const double b((corner[2].tc[n][0] - corner[0].tc[n][0]) * extent.textureWidth / sy);
+      const double c((corner[1].tc[n][1] - corner[0].tc[n][1]) * extent.textureHeight / sx);
+      const double d((corner[2].tc[n][1] - corner[0].tc[n][1]) * extent.textureHeight / sy);
+      const double det(a * d - b * c);
+      inverse[n][0] = d / det;
+      inverse[n][1] = -b / det;
+      inverse[n][2] = -c / det;
+      inverse[n][3] = a / det;
+    }
+
+    for (const double *t : test)
+    {
+      const ViewTiles::Sample s(sample(x + t[0] * size, y + t[1] * size));
+
+      // ̌덷
+      double c[5];
+      for (int k = 0; k < 5; ++k) c[k] = corner[k].blend;
+      double e(std::abs(interpolate(c, t[0], t[1], center) - s.blend) * blendScale);
+
+      // QƂeNX`W̌덷XN[̉fŋ߂
+      for (int n = 0; n < 2; ++n)
+      {
+        if (n == 0 ? s.blend >= 1.0 : s.blend <= 0.0) continue;
+
+        for (int k = 0; k < 5; ++k) c[k] = corner[k].tc[n][0];
+        const double ds((interpolate(c, t[0], t[1], center) - s.tc[n][0]) * extent.textureWidth);
+        for (int k = 0; k < 5; ++k) c[k] = corner[k].tc[n][1];
+        const double dt((interpolate(c, t[0], t[1], center) - s.tc[n][1]) * extent.textureHeight);
+        const double dx(inverse[n][0] * ds + inverse[n][1] * dt), dy(inverse[n][2] * ds + inverse[n][3] * dt);
+        e = std::max(e, std::sqrt(dx * dx + dy * dy));
+      }
+
+      // l܂ȂƂ
+      if (!(e <= tolerance)) return false;
+    }
+
+    return true;
+  }
+
+  // iq𕪊ȂiqƂēo^
+  void addLeaf(int x, int y, int level, bool center = false)
+  {
+    const Cell cell = { x, y, level, center };
+    leaves.push_back(cell);
+
+    const int size(1 << (levels - level));
+    for (int j = y; j < y + size; ++j)
+      std::fill(depth.begin() + j * width + x, depth.begin() + j * width + x + size, static_cast<signed char>(level));
+  }
+
+  // 덷e덷𒴂iqċAIɎl
+  //   ̎Op`ł͌덷傫ĂASɒ_Ύ܂Ȃ番ȂB
+  void refine(int x, int y, int level)
+  {
+    const int size(1 << (levels - level));
+
+    if (level < levels)
+    {
+      const int half(size / 2);
+      const ViewTiles::Sample corner[] =
+      {
+        sample(x, y), sample(x + size, y), sample(x, y + size), sample(x + size, y + size), sample(x + half, y + half)
+      };
+
+      if (!accurate(corner, false, x, y, size))
+      {
+        if (accurate(corner, true, x, y, size))
+        {
+          addLeaf(x, y, level, true);
+          return;
+        }
+
+        refine(x, y, level + 1);
+        refine(x + half, y, level + 1);
+        refine(x, y + half, level + 1);
+        refine(x + half, y + half, level + 1);
+        return;
+      }
+    }
+
+    addLeaf(x, y, level);
+  }
+
+  // iq̕ӂ̊O̍łׂiq𕢂iq̐[ (ʂ̊O -1)
+  int neighbor(int x, int y) const
+  {
+    return x < 0 || x >= width || y < 0 || y >= height ? -1 : depth[y * width + x];
+  }
+
+  // ׂ̊iqƂ̐[̍ 1 𒴂iq𕪊
+  void balance()
+  {
+    for (bool changed = true; changed;)
+    {
+      changed = false;
+
+      for (size_t i = 0; i < leaves.size(); ++i)
+      {
+        const Cell cell(leaves[i]);
+        const int size(1 << (levels - cell.level));
+
+        // lӂɉėׂ̊iq̐[𒲂ׂ
+        bool split(false);
+        for (int k = 0; k < size && !split; ++k)
+        {
+          split = neighbor(cell.x - 1, cell.y + k) > cell.level + 1
+            || neighbor(cell.x + size, cell.y + k) > cell.level + 1
+            || neighbor(cell.x + k, cell.y - 1) > cell.level + 1
+            || neighbor(cell.x + k, cell.y + size) > cell.level + 1;
+        }
+        if (!split) continue;
+
+        // lčŏ̎q̈ʒuɒuAc𖖔ɉ
+        const int half(size / 2), level(cell.level + 1);
+        const Cell first = { cell.x, cell.y, level, false };
+        leaves[i] = first;
+        for (int j = cell.y; j < cell.y + half; ++j)
+          std::fill(depth.begin() + j * width + cell.x, depth.begin() + j * width + cell.x + half, static_cast<signed char>(level));
+        addLeaf(cell.x + half, cell.y, level);
+        addLeaf(cell.x, cell.y + half, level);
+        addLeaf(cell.x + half, cell.y + half, level);
+        changed = true;
+      }
+    }
+  }
+
+  // łׂiq̔PʂƂiq_ (X, Y) ̒_ԍ𓾂
+  GLuint vertex(int X, int Y)
+  {
+    GLuint &index(lattice[Y * (width * 2 + 1) + X]);
+    if (index == ~0u)
+    {
+      index = static_cast<GLuint>(points.size() / 2);
+      points.push_back(static_cast<GLfloat>(X) / width - 1.0f);
+      points.push_back(static_cast<GLfloat>(Y) / height - 1.0f);
+    }
+    return index;
+  }
+
+  // iqOp`ɕ
+  void triangulate()
+  {
+    points.clear();
+    indices.clear();
+    lattice.assign((width * 2 + 1) * (height * 2 + 1), ~0u);
+
+    for (const Cell &cell : leaves)
+    {
+      const int size(1 << (levels - cell.level));
+      const int X0(cell.x * 2), Y0(cell.y * 2), X1(X0 + size * 2), Y1(Y0 + size * 2);
+      const int Xm(X0 + size), Ym(Y0 + size);
+
+      // ׂׂ̊iqƐڂ (, E, , )
+      const bool finer[] =
+      {
+        neighbor(cell.x, cell.y - 1) > cell.level,
+        neighbor(cell.x + size, cell.y) > cell.level,
+        neighbor(cell.x, cell.y + size) > cell.level,
+        neighbor(cell.x - 1, cell.y) > cell.level
+      };
+
+      if (!(cell.center || finer[0] || finer[1] || finer[2] || finer[3]))
+      {
+        // ƉEԑΊpœ̎Op`ɕ
+        const GLuint v00(vertex(X0, Y0)), v10(vertex(X1, Y0)), v01(vertex(X0, Y1)), v11(vertex(X1, Y1));
+        const GLuint triangles[] = { v00, v10, v11, v00, v11, v01 };
+        indices.insert(indices.end(), triangles, triangles + 6);
+        continue;
+      }
+
+      // Sɒ_ůׂׂiqƐڂƂ́Aڂӂɒ_Ċiq̒S`ɕ
+      GLuint ring[8];
+      int n(0);
+      ring[n++] = vertex(X0, Y0);
+      if (finer[0]) ring[n++] = vertex(Xm, Y0);
+      ring[n++] = vertex(X1, Y0);
+      if (finer[1]) ring[n++] = vertex(X1, Ym);
+      ring[n++] = vertex(X1, Y1);
+      if (finer[2]) ring[n++] = vertex(Xm, Y1);
+      ring[n++] = vertex(X0, Y1);
+      if (finer[3]) ring[n++] = vertex(X0, Ym);
+      const GLuint center(vertex(Xm, Ym));
+      for (int k = 0; k < n; ++k)
+      {
+        indices.push_back(center);
+        indices.push_back(ring[k]);
+        indices.push_back(ring[(k + 1) % n]);
+      }
+    }
+  }
+
+public:
+
+  // RXgN^
+  //   program ͓WJɎgVF[_̃vOAvsrc ͂̃o[ebNXVF[_̃\[Xt@CA
+  //   tolerance ͋e덷 (XN[̉f)Alevels ͊{̊iq𕪊ő̉񐔁B
+  AdaptiveMesh(GLuint program, const char *vsrc, double tolerance, int levels)
+    : model(ViewTiles::getModel(vsrc)), tolerance(tolerance), levels(std::min(std::max(levels, 0), 7))
+    , vao(0), vbo(0), ibo(0), pointLoc(-1), vertexCount(0), indexCount(0), built(0)
+  {
+    // e덷 0 ȂgȂ
+    if (!(tolerance > 0.0)) return;
+
+    // _ point ɒ_ʒun
+    pointLoc = glGetAttribLocation(program, "point");
+    if (pointLoc < 0) return;
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(pointLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(pointLoc);
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  // fXgN^
+  virtual ~AdaptiveMesh()
+  {
+    glDeleteBuffers(1, &ibo);
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+  }
+
+  // bVg邩ǂ
+  //   ẽfȂΎgȂB
+  bool isValid() const
+  {
+    return vao != 0 && model != ViewTiles::WHOLE;
+  }
+
+  // WJɎgVF[_؂ւƂɓẽfƒ_̏ꏊύX
+  //   program ͐؂ւVF[_̃vOAvsrc ͂̃o[ebNXVF[_̃\[Xt@CB
+  //    update() ŃbV蒼B
+  void setModel(GLuint program, const char *vsrc)
+  {
+    model = ViewTiles::getModel(vsrc);
+    key.clear();
+    if (vao == 0) return;
+
+    // _ point ̏ꏊ̓vOƂɃN̂ƂɌ܂
+    const GLint location(glGetAttribLocation(program, "point"));
+    if (location < 0 || location == pointLoc) return;
+    glBindVertexArray(vao);
+    glDisableVertexAttribArray(pointLoc);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(location);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    pointLoc = location;
+  }
+
+  // WJ̃p[^r[|[g̑傫OƈႦ΃bV蒼
+  //   screen, focal, rotation (sD), circle ͓WJɎgVF[_ uniform ϐƓ́A
+  //   extent ͔wieNX`ƌ̃t[̑傫B蒼 true ԂB
+  bool update(const GLfloat *screen, GLfloat focal, const GLfloat *rotation, const GLfloat *circle,
+    const ViewTiles::Extent &extent)
+  {
+    // ݂̃r[|[g
+    GLint current[4];
+    glGetIntegerv(GL_VIEWPORT, current);
+
+    // bV̌`߂l
+    std::vector<GLfloat> values(screen, screen + 4);
+    values.push_back(static_cast<GLfloat>(current[2]));
+    values.push_back(static_cast<GLfloat>(current[3]));
+    values.push_back(focal);
+    values.insert(values.end(), rotation, rotation + 16);
+    values.insert(values.end(), circle, circle + 4);
+    const int sizes[] =
+    {
+      extent.textureWidth, extent.textureHeight, extent.frameWidth, extent.frameHeight, extent.cropX, extent.cropY
+    };
+    for (int size : sizes) values.push_back(static_cast<GLfloat>(size));
+
+    // p[^ςĂȂ΍蒼Ȃ
+    if (values == key) return false;
+    key.swap(values);
+
+    // p[^ۑ
+    for (int k = 0; k < 3; ++k)
+      for (int l = 0; l < 3; ++l)
+        r[k * 3 + l] = rotation[k * 4 + l];
+    this->focal = focal;
+    std::copy(screen, screen + 4, this->screen);
+    std::copy(circle, circle + 4, this->circle);
+    this->extent = extent;
+    std::copy(current, current + 4, viewport);
+
+    // {̊iq̐̓XN[̃AXyNgɍ킹
+    rows = baseRows;
+    columns = std::max(static_cast<int>(std::lround(baseRows * screen[0] / screen[1])), 1);
+    width = columns << levels;
+    height = rows << levels;
+
+    // {̊iqƂɕ
+    leaves.clear();
+    depth.assign(width * height, 0);
+    for (int j = 0; j < rows; ++j)
+      for (int i = 0; i < columns; ++i)
+        refine(i << levels, j << levels, 0);
+
+    // ׂ荇iq̐[̍ 1 ܂łɂĎOp`ɕ
+    balance();
+    triangulate();
+
+    // _obt@ɓ]
+    vertexCount = static_cast<GLsizei>(points.size() / 2);
+    indexCount = static_cast<GLsizei>(indices.size());
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof (GLfloat), points.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof (GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    ++built;
+    return true;
+  }
+
+  // bV`悷
+  void draw() const
+  {
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+  }
+
+  // _̐𓾂
+  GLsizei getVertexCount() const
+  {
+    return vertexCount;
+  }
+
+  // Op`̐𓾂
+  GLsizei getTriangleCount() const
+  {
+    return indexCount / 3;
+  }
+
+  // bV񐔂𓾂
+  unsigned long getBuilt() const
+  {
+    return built;
+  }
+};
@@ -0,0 +1,357 @@
+#pragma once
+
+//
+// `摜̔񓯊̓ǂݏoƃt@Cւ̏o
+//
+
+// ⏕vO
+#include "gg.h"
+using namespace gg;
+
+// OpenGL ̃ReLXgɊւ鏈
+#include "Context.h"
+
+// oɍs
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// WCu
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+
+// `摜sNZobt@IuWFNg̃Oɔ񓯊ɓǂݏoA
+// ̃[JXbhŘAԂ̉摜t@CɏoNX
+//   `Xbh glReadPixels() sNZobt@IuWFNgɔsătFXuŎ̃t[ɐi݁A
+//   ǂݏoÎ珇Ƀ[JXbhɓnB󂢂ĂsNZobt@IuWFNgȂ
+//   ΂Âǂݏo̊o̊҂̂ŁAfR[hA`AǂݏoAodȂA
+//   x͂̍vł͂Ȃłx̂ɗB
+class BatchWriter
+{
+  // ǂݏoɎgsNZobt@IuWFNg
+  struct Slot
+  {
+    // sNZobt@IuWFNg
+    GLuint buffer;
+
+    // iIɃ}bv (}bvłȂ nullptr)
+    const GLubyte *mapped;
+
+    // }bvłȂƂɓǂݏo摜𕡎ʂ郁
+    std::vector<GLubyte> memory;
+
+    // ǂݏo̊҂tFX (ǂݏołȂ nullptr)
+    GLsync fence;
+
+    // ot[̔ԍƉ摜̑傫
+    unsigned long frame;
+    GLsizei width, height;
+
+    // [JXbhoȂ true
+    bool writing;
+  };
+
+  // sNZobt@IuWFNg̃O
+  std::vector<Slot> slots;
+
+  // ɓǂݏoɎgsNZobt@IuWFNg̔ԍ
+  size_t next;
+
+  // ǂݏo摜̍ő̑傫
+  const GLsizei maxWidth, maxHeight;
+
+  // ot@C̏ (t[̔ԍ printf ̏Ŗߍ)
+  const std::string pattern;
+
+  // ǂݏot[̐
+  unsigned long frames;
+
+  // o҂sNZobt@IuWFNg̑҂s
+  std::deque<Slot *> queue;
+
+  // ҂sƏȍԂ~[ebNXƏϐ
+  std::mutex mtx;
+  std::condition_variable cond;
+
+  // [JXbh
+  std::vector<std::thread> workers;
+
+  // [JXbh̎s
+  bool run;
+
+  // ot[̐ƏoɎst[̐
+  unsigned long written, failed;
+
+  // [JXbhoɗvԂ̍v
+  double writeTime;
+
+  // `Xbhǂݏo̊҂蕡ʂ肷̂ɗvԂ̍v
+  double readTime;
+
+  // `Xbho̊҂Ԃ̍v
+  double stallTime;
+
+  // Rs[RXgN^𕕂
+  BatchWriter(const BatchWriter &c);
+
+  // 𕕂
+  BatchWriter &operator=(const BatchWriter &w);
+
+  // oߎԂbŋ߂
+  static double elapsed(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // ǂݏo̊҂ă[JXbhɓn
+  //   wait  false ȂǂݏoIĂȂΉ false ԂB
+  bool complete(Slot &slot, bool wait)
+  {
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    // ǂݏo̊҂
+    if (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+    {
+      if (!wait) return false;
+      while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    // iIɃ}bvĂȂ΃}bvăNCAg̃ɕʂ
+    if (!slot.mapped)
+    {
+      const GLsizeiptr size(static_cast<GLsizeiptr>(slot.width) * slot.height * 3);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      const void *const memory(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+      if (memory) std::copy(static_cast<const GLubyte *>(memory), static_cast<const GLubyte *>(memory) + size, slot.memory.begin());
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    readTime += elapsed(start);
+
+    // [JXbhɓn
+    std::unique_lock<std::mutex> lock(mtx);
+    slot.writing = true;
+    queue.push_back(&slot);
+    lock.unlock();
+    cond.notify_one();
+
+    return true;
+  }
+
+  // ҂s񂩂ot[摜t@Cɏo ([JXbh)
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true)
+    {
+      // ot[܂ő҂
+      cond.wait(lock, [this]() { return !run || !queue.empty(); });
+      if (queue.empty()) break;
+      Slot &slot(*queue.front());
+      queue.pop_front();
+      lock.unlock();
+
+      // t[̔ԍt@Cɖߍ
+      std::vector<char> name(pattern.size() + 32);
+      snprintf(name.data(), name.size(), pattern.c_str(), slot.frame);
+
+      // ɕ RGB ̉摜̂܂ TGA t@Cɏo
+      const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+      const bool saved(ggSaveTga(name.data(), slot.mapped ? slot.mapped : slot.memory.data(), slot.width, slot.height, 3));
+      const double time(elapsed(start));
+
+      // sNZobt@IuWFNg󂯂
+      lock.lock();
+      writeTime += time;
+      ++(saved ? written : failed);
+      slot.writing = false;
+      cond.notify_all();
+    }
+  }
+
+public:
+
+  // RXgN^
+  //   pattern ͏ot@C̏ŁAt[̔ԍ (unsigned long)  %06lu ȂǂŖߍށB
+  //   width, height ͓ǂݏo摜̍ő̑傫Abuffers ̓sNZobt@IuWFNg̐A
+  //   threads ͏o[JXbh̐ (0 Ȃn[hEFÃXbh̔)B
+  BatchWriter(const char *pattern, GLsizei width, GLsizei height, int buffers, int threads)
+    : next(0), maxWidth(width), maxHeight(height), pattern(pattern), frames(0)
+    , run(true), written(0), failed(0), writeTime(0.0), readTime(0.0), stallTime(0.0)
+  {
+    // iIɃ}bvł邩ǂ
+    GLint major, minor;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    const bool persistent(major > 4 || (major == 4 && minor >= 4) || hasExtension("GL_ARB_buffer_storage"));
+
+    // 1 t[̃oCg
+    const GLsizeiptr capacity(static_cast<GLsizeiptr>(width) * height * 3);
+
+    // sNZobt@IuWFNg̃O쐬
+    slots.resize(std::max(buffers, 2));
+    for (auto &slot : slots)
+    {
+      glGenBuffers(1, &slot.buffer);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      slot.mapped = nullptr;
+      if (persistent)
+      {
+        // ǂݏopɉiIɃ}bv (NCAg̃ɒu悤ɋ߂)
+        const GLbitfield flags(GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, capacity, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+        slot.mapped = static_cast<const GLubyte *>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, capacity, flags));
+      }
+      if (!slot.mapped)
+      {
+        // }bvłȂΓǂݏoтɃ}bvăNCAg̃ɕʂ
+        if (persistent)
+        {
+          glDeleteBuffers(1, &slot.buffer);
+          glGenBuffers(1, &slot.buffer);
+          glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        }
+        glBufferData(GL_PIXEL_PACK_BUFFER, capacity, nullptr, GL_STREAM_READ);
+        slot.memory.resize(capacity);
+      }
+      slot.fence = nullptr;
+      slot.frame = 0;
+      slot.width = slot.height = 0;
+      slot.writing = false;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // [JXbhN
+    if (threads <= 0) threads = std::max(static_cast<int>(std::thread::hardware_concurrency() / 2), 1);
+    for (int i = 0; i < threads; ++i) workers.emplace_back(&BatchWriter::work, this);
+  }
+
+  // fXgN^
+  virtual ~BatchWriter()
+  {
+    // cĂt[oă[JXbh~߂
+    if (hasCurrentContext()) flush();
+    mtx.lock();
+    run = false;
+    mtx.unlock();
+    cond.notify_all();
+    for (auto &worker : workers) worker.join();
+
+    // sNZobt@IuWFNg폜
+    if (hasCurrentContext())
+    {
+      for (auto &slot : slots)
+      {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.mapped)
+        {
+          glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+          glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glDeleteBuffers(1, &slot.buffer);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+  }
+
+  // ݂̓ǂݏõt[obt@̋`ǂݏoĎ̔ԍ̃t@Cɏo
+  //   ǂݏo͔񓯊ɍsAo̓[JXbhŝŁAs炷ɖ߂B
+  //   ǂݏo̓EBhEȂobNobt@Ȃ̂ŁAJ[obt@ւOɌĂԁB
+  void capture(GLint x, GLint y, GLsizei width, GLsizei height)
+  {
+    // ǂݏoIĂ̂[JXbhɓn
+    for (auto &slot : slots) if (slot.fence) complete(slot, false);
+
+    // ̃sNZobt@IuWFNg܂ǂݏoȂ犮҂
+    Slot &slot(slots[next]);
+    if (slot.fence) complete(slot, true);
+
+    // oȂ犮҂
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [&slot]() { return !slot.writing; });
+    lock.unlock();
+    stallTime += elapsed(start);
+
+    // sNZobt@IuWFNgɓǂݏoătFXu
+    slot.width = std::min(width, maxWidth);
+    slot.height = std::min(height, maxHeight);
+    slot.frame = frames++;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, slot.width, slot.height, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // ̃sNZobt@IuWFNgɐi
+    next = (next + 1) % slots.size();
+  }
+
+  // ǂݏoׂẴt[oI܂ő҂
+  void flush()
+  {
+    // ǂݏo̊Âɑ҂ă[JXbhɓn
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+      Slot &slot(slots[(next + i) % slots.size()]);
+      if (slot.fence) complete(slot, true);
+    }
+
+    // oI܂ő҂
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this]() { return queue.empty() && written + failed == frames; });
+  }
+
+  // ǂݏot[̐𓾂
+  unsigned long getFrames() const
+  {
+    return frames;
+  }
+
+  // ot[̐𓾂
+  unsigned long getWritten()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return written;
+  }
+
+  // oɎst[̐𓾂
+  unsigned long getFailed()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return failed;
+  }
+
+  // [JXbh̐𓾂
+  int getThreads() const
+  {
+    return static_cast<int>(workers.size());
+  }
+
+  // [JXbh 1 t[̏oɗvԂ̕ς𓾂
+  double getWriteTime()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return written + failed > 0 ? writeTime / (written + failed) : 0.0;
+  }
+
+  // `Xbh 1 t[̓ǂݏo̊҂Ď󂯎̂ɗvԂ̕ς𓾂
+  double getReadTime() const
+  {
+    return frames > 0 ? readTime / frames : 0.0;
+  }
+
+  // `Xbho̊҂Ԃ̍v𓾂
+  double getStallTime() const
+  {
+    return stallTime;
+  }
+};
@@ -10,6 +10,11 @@
 // OpenCV
 #include <opencv2/highgui/highgui.hpp>
 
+// WCu
+#include <algorithm>
+#include <deque>
+#include <iostream>
+
 // OpenCV găLv`NX
 class CamCv
   : public Camera
@@ -17,15 +22,33 @@ class CamCv
   // OpenCV ̃Lv`foCX
   cv::VideoCapture camera;
 
-  // OpenCV ̃Lv`foCX擾t[
-  cv::Mat frame;
+  // [r[t@C̐擪̃t[\
+  std::chrono::steady_clock::time_point origin;
 
-  // ݂̃t[̎
-  double frameTime;
+  // [r[t@Ĉ悤Ƀt[̎ɍ킹čĐȂ true
+  bool playback;
 
   // IoƗ
   int exposure, gain;
 
+  // [r[t@Cǂ݂t[̐ (0 Ȃǂ݂Ȃ)
+  int ahead;
+
+  // ǂ݂t[̔ԍƕ\ׂ̑҂s
+  std::deque<std::pair<int, std::chrono::steady_clock::time_point>> queue;
+
+  // ǂ݂Ɏg󂫃t[̔ԍ
+  std::vector<int> spare;
+
+  // \ׂt[҂sɂȂ
+  std::atomic<unsigned long> underrun;
+
+  // ǂ݃Xbh[r[t@C̍ŌɒBĊ߂ĂȂ true (waitMutex ŕی삷)
+  bool rewinding;
+
+  // t[oƂ̑҂s̒̍vƎo
+  std::atomic<unsigned long> depthSum, depthCount;
+
   // Lv`foCX
   bool init(int initial_width, int initial_height, int initial_fps)
   {
@@ -38,10 +61,10 @@ class CamCv
     if (camera.grab())
     {
       // ŏ̃t[擾ɂ
-      glfwSetTime(0.0);
+      origin = std::chrono::steady_clock::now();
 
-      // ŏ̃t[̎ 0 ɂ
-      frameTime = 0.0;
+      // t[΃[r[t@CƂăt[̎ɍ킹čĐ
+      playback = camera.get(CV_CAP_PROP_FRAME_COUNT) > 0.0;
 
       // Lv`t[̃TCY擾
       width = static_cast<GLsizei>(camera.get(CV_CAP_PROP_FRAME_WIDTH));
@@ -58,11 +81,23 @@ class CamCv
       // Lv`t[̃tH[}bgݒ肷
       format = GL_BGR;
 
-      // t[oăLv`p̃mۂ
-      camera.retrieve(frame, 3);
+      // Lv`p̃mۂ (ǂ݂Ƃ͐ǂ݂镪mۂ)
+      allocate(playback ? ahead + 3 : 3);
+
+      // ŏ̃t[o
+      if (!retrieve(getBackBuffer())) return false;
+
+      // `Xbhɓn
+      publish();
 
-      // t[Lv`ꂽƂL^
-      buffer = frame.data;
+      // ǂ݂Ƃ͎Odobt@OŎgĂȂt[󂫃t[ɂ
+      spare.clear();
+      queue.clear();
+      if (playback && ahead > 0)
+      {
+        spare.push_back(getBack());
+        for (int i = 3; i < getFrameCount(); ++i) spare.push_back(i);
+      }
 
       // Jg
       return true;
@@ -72,66 +107,251 @@ class CamCv
     return false;
   }
 
+  // t[ memory ɐ؂o
+  //   t[̃TCY`ςĂeNX`Ɏ܂Ȃ̂ŁAG[\ false ԂB
+  bool retrieve(GLubyte *memory)
+  {
+    // ރt[̃ cv::Mat ƂĈ
+    cv::Mat frame(height, width, CV_8UC3, memory);
+
+    // t[𒼐ڂ̃ɐ؂o
+    camera.retrieve(frame, 3);
+
+    // mۂĂȂ΂̂܂܎g
+    if (frame.data == memory) return true;
+
+    // TCY`ςĂgȂ
+    if (frame.total() != static_cast<size_t>(width * height) || frame.elemSize() != 3)
+    {
+      std::cerr << "Error: Frame size or format changed from " << width << "x" << height
+        << " to " << frame.cols << "x" << frame.rows << ".\n";
+      return false;
+    }
+
+    // TCYƌ`̂܂܃mۂꂽ畡ʂ
+    std::copy(frame.data, frame.data + frame.total() * frame.elemSize(), memory);
+    return true;
+  }
+
+  // t[̎𓾂
+  std::chrono::steady_clock::time_point getFrameTime() const
+  {
+    const std::chrono::duration<double, std::milli> time(camera.get(CV_CAP_PROP_POS_MSEC));
+    return origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(time);
+  }
+
+  // [r[t@C̃t[󂫃t[ɐǂ݂đ҂sɓ (ǂ݃Xbh)
+  //   I t[̂悤ɃfR[hɎԂt[ĂA
+  //   ҂sɗ߂Ăt[ŕ\𑱂B
+  void decode()
+  {
+    // t[̊Ԋu
+    const double fps(camera.get(CV_CAP_PROP_FPS));
+    const std::chrono::duration<double> interval(fps > 0.0 ? 1.0 / fps : 1.0 / 30.0);
+
+    // Ōɐǂ݂t[̎
+    std::chrono::steady_clock::time_point last(origin);
+
+    // Xbhs̊
+    while (true)
+    {
+      // 󂫃t[ł܂ő҂
+      std::unique_lock<std::mutex> wait_lock(waitMutex);
+      waitCondition.wait(wait_lock, [this]() { return !run || !spare.empty(); });
+      if (!run) break;
+
+      // 󂫃t[o
+      const int frame(spare.back());
+      spare.pop_back();
+      wait_lock.unlock();
+
+      // Lv`foCXbN
+      std::unique_lock<std::mutex> lock(mtx);
+
+      // fR[hJn
+      const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+      // ̃t[݂
+      if (camera.grab())
+      {
+        // 󂫃t[ɐ؂o (TCYςĂǂ݂߂)
+        if (!retrieve(getFrame(frame))) break;
+        countDecode(start);
+
+        // t[̎߂
+        last = getFrameTime();
+
+        // Lv`foCX̃bN
+        lock.unlock();
+
+        // ҂sɒǉ
+        wait_lock.lock();
+        queue.emplace_back(frame, last);
+        rewinding = false;
+        wait_lock.unlock();
+        waitCondition.notify_all();
+
+        // ̃t[ɐi
+        continue;
+      }
+
+      // o󂫃t[߂A߂̊Ԃ͑҂s񂪋ɂȂĂȂ悤ɂ
+      wait_lock.lock();
+      spare.push_back(frame);
+      rewinding = true;
+      wait_lock.unlock();
+
+      // t[擾łȂ烀[r[t@C߂
+      if (camera.set(CV_CAP_PROP_POS_FRAMES, 0.0))
+      {
+        // 擪̃t[̎Ō̃t[̎̎ɂ
+        origin = last + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+
+        // ̃t[ɐi
+        continue;
+      }
+
+      // Lv`foCX̃bN
+      lock.unlock();
+
+      // Lv`foCX񕜂̂҂
+      if (!wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(10L), false)) break;
+    }
+  }
+
+  // ǂ݂t[̎ɕ`Xbhɓn
+  void schedule()
+  {
+    // ǂ݃XbhN
+    rewinding = false;
+    std::thread decoder(&CamCv::decode, this);
+
+    // ǂ݂t[łn true
+    bool delivered(false);
+
+    // Xbhs̊
+    while (true)
+    {
+      // ҂s̐擪̃t[
+      std::pair<int, std::chrono::steady_clock::time_point> next;
+
+      // ҂sbN
+      std::unique_lock<std::mutex> lock(waitMutex);
+
+      // ҂s񂪋Ȃǂ݂ԂɍĂȂ̂
+      if (queue.empty())
+      {
+        // ŏ̃t[nOƊ߂ĂԂĉ񐔂𐔂Aǂ݂҂
+        if (delivered && !rewinding) ++underrun;
+        waitCondition.wait(lock, [this]() { return !run || !queue.empty(); });
+      }
+      if (!run) break;
+
+      // ҂s̒L^
+      depthSum += static_cast<unsigned long>(queue.size());
+      ++depthCount;
+
+      // 擪̃t[o
+      next = queue.front();
+      queue.pop_front();
+      lock.unlock();
+
+      // t[̎ɂȂÕt[󂯎܂ő҂
+      if (!wait(next.second, true))
+      {
+        // ~Ȃot[҂sɖ߂Ă
+        lock.lock();
+        queue.push_front(next);
+        break;
+      }
+
+      // `XbhɓnAɕԂꂽt[󂫃t[ɂ
+      const int frame(exchange(next.first, next.second));
+      delivered = true;
+      lock.lock();
+      spare.push_back(frame);
+      lock.unlock();
+      waitCondition.notify_all();
+    }
+
+    // ǂ݃Xbhƍ
+    if (decoder.joinable()) decoder.join();
+  }
+
   // t[Lv`
+  //   Cuf grab() t[̓҂̂ł̂܂܃Lv`𑱂A
+  //   [r[t@C͑Õt[󂯎ꂽ玟̃t[؂oāA
+  //   ̎ɂȂ`XbhɓnB
   virtual void capture()
   {
-    // 炩߃Lv`foCXbN
-    mtx.lock();
+    // [r[t@Cǂ݂Ȃǂ݂t[n
+    //   ꊇϊł͎ɍ킹Ȃ̂Őǂ݂AOdobt@OŃfR[hƕ`d˂B
+    if (playback && getFrameCount() > 3 && !isBatch()) return schedule();
 
     // Xbhs̊
     while (run)
     {
-      // obt@̂ƂoߎԂ݂̃t[̎ɒBĂ
-      if (!buffer && glfwGetTime() >= frameTime)
+      // Lv`foCXbN
+      std::unique_lock<std::mutex> lock(mtx);
+
+      // fR[hJn
+      const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+      // ̃t[݂
+      if (camera.grab())
       {
-        // ̃t[݂
-        if (camera.grab())
-        {
-          // Lv`t[̎L^
-          frameTime = camera.get(CV_CAP_PROP_POS_MSEC) * 0.001;
-
-          // t[؂o
-          camera.retrieve(frame, 3);
-
-          // t[XV
-          buffer = frame.data;
-
-          // ̃t[ɐi
-          continue;
-        }
-
-        // t[擾łȂ烀[r[t@C߂
-        if (camera.set(CV_CAP_PROP_POS_FRAMES, 0.0))
-        {
-          // oߎԂZbg
-          glfwSetTime(0.0);
-
-          // t[̎Zbg
-          frameTime = 0.0;
-
-          // ̃t[ɐi
-          continue;
-        }
+        // Lv`L^
+        std::chrono::steady_clock::time_point time(std::chrono::steady_clock::now());
+
+        // t[؂o (TCYςĂLv`߂)
+        if (!retrieve(getBackBuffer())) break;
+        countDecode(start);
+
+        // [r[t@CȂt[̎߂
+        if (playback) time = getFrameTime();
+
+        // Lv`foCX̃bN
+        lock.unlock();
+
+        // [r[t@CȂt[̎ɂȂÕt[󂯎܂ő҂
+        if (playback && !wait(time, true)) break;
+
+        // `Xbhɓn
+        //   `Xbh͎󂯓np̃t[ƌ邾Ȃ̂ŁA
+        //   `Xbht[]ĂԂLv`𑱂B
+        publish(time);
+
+        // ̃t[ɐi
+        continue;
       }
 
-      // t[؂oȂ΃bN
-      mtx.unlock();
+      // ꊇϊȂ烀[r[t@C̍ŌŏI
+      if (playback && finish()) break;
 
-      // ̃Xbh\[XɃANZX邽߂ɏ҂Ă
-      std::this_thread::sleep_for(std::chrono::milliseconds(10L));
+      // t[擾łȂ烀[r[t@C߂
+      if (camera.set(CV_CAP_PROP_POS_FRAMES, 0.0))
+      {
+        // 擪̃t[̎Zbg
+        origin = std::chrono::steady_clock::now();
 
-      // ܂Lv`foCXbN
-      mtx.lock();
-    }
+        // ̃t[ɐi
+        continue;
+      }
 
-    // IƂ̓bN
-    mtx.unlock();
+      // Lv`foCX̃bN
+      lock.unlock();
+
+      // Lv`foCX񕜂̂҂
+      if (!wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(10L), false)) break;
+    }
   }
 
 public:
 
   // RXgN^
-  CamCv() {}
+  CamCv()
+    : playback(false), exposure(0), gain(0), ahead(0), underrun(0), rewinding(false), depthSum(0), depthCount(0)
+  {}
 
   // fXgN^
   virtual ~CamCv()
@@ -166,6 +386,26 @@ public:
     return false;
   }
 
+  // [r[t@Cǂ݂t[̐w肷
+  //   t[̃mۂO (open() ̑O) Ɏw肷B
+  void setAhead(int frames)
+  {
+    ahead = std::max(frames, 0);
+  }
+
+  // \ׂt[ǂ݂̑҂sɂȂ񐔂𓾂
+  unsigned long getUnderrun() const
+  {
+    return underrun;
+  }
+
+  // t[oƂ̐ǂ݂̑҂s̒̕ς𓾂
+  double getQueueDepth() const
+  {
+    const unsigned long count(depthCount);
+    return count > 0 ? static_cast<double>(depthSum) / count : 0.0;
+  }
+
   // Ioグ
   virtual void increaseExposure()
   {
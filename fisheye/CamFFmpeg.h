@@ -0,0 +1,332 @@
+#pragma once
+
+//
+// FFmpeg gLv`
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// FFmpeg
+extern "C"
+{
+#  include <libavformat/avformat.h>
+#  include <libavcodec/avcodec.h>
+}
+#if defined(_MSC_VER)
+#  pragma comment(lib, "avformat.lib")
+#  pragma comment(lib, "avcodec.lib")
+#  pragma comment(lib, "avutil.lib")
+#endif
+
+// WCu
+#include <cstring>
+
+// FFmpeg găfR[hNX
+//   t[PʂƃXCXPʂ̃}`XbhŃfR[hABGR ɕϊɓ]B
+//   4:2:0 (YUV420P, NV12) ͋Px GL_RED ŁAF (U, V) ̑gɂďc GL_RG ŁA
+//   4:2:2 (YUYV422)  (Y, U), (Y, V) ̑g GL_RG œ]B
+class CamFFmpeg
+  : public Camera
+{
+  // ̓t@C^Xg[
+  AVFormatContext *formatContext;
+
+  // fR[_
+  AVCodecContext *codecContext;
+
+  // fR[ht[Ɠǂݍ񂾃pPbg
+  AVFrame *frame;
+  AVPacket *packet;
+
+  // fR[hrfIXg[̔ԍ
+  int stream;
+
+  // fR[hɎgXbh̐ (0 Ȃ玩) ƃXbh̎g
+  int threads, threadType;
+
+  // Xg[̎̒P (b)
+  double timeBase;
+
+  // Xg[̐擪̃t[\
+  std::chrono::steady_clock::time_point origin;
+
+  // ŌɃfR[ht[̎ (b) ƃt[̊Ԋu (b)
+  double last, interval;
+
+  // fR[_ɓ͂̏Im点 true
+  bool draining;
+
+  // ̃t[fR[h
+  //   t[ꂽ trueAXg[̏I肩G[Ȃ false ԂB
+  bool receive()
+  {
+    while (true)
+    {
+      // fR[hς񂾃t[Ύo
+      const int status(avcodec_receive_frame(codecContext, frame));
+      if (status == 0) return true;
+      if (status != AVERROR(EAGAIN)) return false;
+
+      // fR[_pPbgKvƂĂ̂ɓ͂IĂΏI
+      if (draining) return false;
+
+      // ̃pPbgǂݍ
+      if (av_read_frame(formatContext, packet) < 0)
+      {
+        // ͂IfR[_ɎcĂt[o
+        avcodec_send_packet(codecContext, nullptr);
+        draining = true;
+        continue;
+      }
+
+      // rfIXg[̃pPbgȂfR[_ɑ
+      if (packet->stream_index == stream) avcodec_send_packet(codecContext, packet);
+      av_packet_unref(packet);
+    }
+  }
+
+  // Xg[̐擪Ɋ߂
+  //   Xg[̊Jn 0 Ƃ͌Ȃ̂ŁA̎ɖ߂B
+  bool rewind()
+  {
+    const int64_t startTime(formatContext->streams[stream]->start_time);
+    const int64_t start(startTime != AV_NOPTS_VALUE ? startTime : 0);
+    if (av_seek_frame(formatContext, stream, start, AVSEEK_FLAG_BACKWARD) < 0) return false;
+    avcodec_flush_buffers(codecContext);
+    draining = false;
+
+    // 擪̃t[̎Ō̃t[̎̎ɂ
+    origin += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(last + interval - start * timeBase));
+    last = start * timeBase;
+
+    return true;
+  }
+
+  // fR[ht[̎𓾂
+  std::chrono::steady_clock::time_point getFrameTime()
+  {
+    // ȂΑÕt[̎̎ɂ
+    const int64_t pts(frame->best_effort_timestamp);
+    last = pts != AV_NOPTS_VALUE ? pts * timeBase : last + interval;
+
+    return origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(last));
+  }
+
+  // fR[ht[Lv`Xbhރt[Ɋi[
+  //   ؂oƂ͐؂o͈͂i[B
+  void store()
+  {
+    GLubyte *const buffer(getBackBuffer());
+
+    // i[͈
+    const int left(getCropX()), top(getCropY()), w(getCropWidth()), h(getCropHeight());
+
+    if (frame->format == AV_PIX_FMT_YUYV422)
+    {
+      // (Y, U), (Y, V) ̑ĝ܂ܕʂ
+      for (int y = top; y < top + h; ++y)
+        memcpy(buffer + (y * width + left) * 2, frame->data[0] + y * frame->linesize[0] + left * 2, w * 2);
+      return;
+    }
+
+    // Px̕ʂ𕡎ʂ
+    for (int y = top; y < top + h; ++y)
+      memcpy(buffer + y * width + left, frame->data[0] + y * frame->linesize[0] + left, w);
+
+    // F̕ (c̉𑜓x)
+    GLubyte *const uv(buffer + chromaOffset);
+
+    if (frame->format == AV_PIX_FMT_NV12)
+    {
+      // (U, V) ̑gɂȂĂ̂ł̂܂ܕʂ
+      for (int y = top / 2; y < (top + h) / 2; ++y)
+        memcpy(uv + y * width + left, frame->data[1] + y * frame->linesize[1] + left, w);
+    }
+    else
+    {
+      // U  V ̕ʂ (U, V) ̑gɕבւ
+      for (int y = top / 2; y < (top + h) / 2; ++y)
+      {
+        const uint8_t *const u(frame->data[1] + y * frame->linesize[1]);
+        const uint8_t *const v(frame->data[2] + y * frame->linesize[2]);
+        GLubyte *const dst(uv + y * width);
+        for (int x = left / 2; x < (left + w) / 2; ++x)
+        {
+          dst[x * 2] = u[x];
+          dst[x * 2 + 1] = v[x];
+        }
+      }
+    }
+  }
+
+  // t[Lv`
+  //   t[̎ɂȂÕt[󂯎ꂽ`XbhɓnB
+  virtual void capture()
+  {
+    // Xbhs̊
+    //   fR[_͂̃XbhgȂ̂ŃbNȂB
+    while (run)
+    {
+      // fR[hJn
+      const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+      // ̃t[݂
+      if (receive())
+      {
+        // t[i[
+        store();
+        countDecode(start);
+
+        // t[̎߂
+        const std::chrono::steady_clock::time_point time(getFrameTime());
+
+        // t[̎ɂȂÕt[󂯎܂ő҂
+        if (!wait(time, true)) break;
+
+        // `Xbhɓn
+        publish(time);
+
+        // ̃t[ɐi
+        continue;
+      }
+
+      // ꊇϊȂŌŏIAłȂΊ߂Ď̃t[ɐi
+      if (finish()) break;
+      if (rewind()) continue;
+
+      // ͂񕜂̂҂
+      if (!wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(10L), false)) break;
+    }
+  }
+
+  // ͂
+  void close()
+  {
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&codecContext);
+    avformat_close_input(&formatContext);
+  }
+
+public:
+
+  // RXgN^
+  CamFFmpeg()
+    : formatContext(nullptr), codecContext(nullptr), frame(nullptr), packet(nullptr)
+    , stream(-1), threads(0), threadType(FF_THREAD_FRAME | FF_THREAD_SLICE)
+    , timeBase(0.0), last(0.0), interval(0.0), draining(false)
+  {}
+
+  // fXgN^
+  virtual ~CamFFmpeg()
+  {
+    // Xbh~
+    stop();
+
+    // ͂
+    close();
+  }
+
+  // fR[hɎgXbh̐w肷
+  //   count  0 Ȃ玩Aframe  slice ̓t[PʂƃXCXPʂ̃XbhgǂB
+  //   open() ̑OɎw肷B
+  void setThreads(int count, bool frame_threads = true, bool slice_threads = true)
+  {
+    threads = std::max(count, 0);
+    threadType = (frame_threads ? FF_THREAD_FRAME : 0) | (slice_threads ? FF_THREAD_SLICE : 0);
+  }
+
+  // t@C^lbg[N͂
+  //   file ̓t@C URL ŁAOpenCV ̂悤ȃfoCX̔ԍ͎gȂB
+  bool open(const char *file)
+  {
+    // ͂JăXg[̏𓾂
+    if (!file || avformat_open_input(&formatContext, file, nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(formatContext, nullptr) < 0)
+    {
+      close();
+      return false;
+    }
+
+    // rfIXg[Ƃ̃fR[_T
+    stream = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (stream < 0)
+    {
+      close();
+      return false;
+    }
+    const AVStream *const video(formatContext->streams[stream]);
+    const AVCodec *const codec(avcodec_find_decoder(video->codecpar->codec_id));
+    if (!codec)
+    {
+      close();
+      return false;
+    }
+
+    // fR[_}`XbhŊJ
+    codecContext = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecContext, video->codecpar);
+    codecContext->thread_count = threads;
+    codecContext->thread_type = threadType;
+    if (avcodec_open2(codecContext, codec, nullptr) < 0)
+    {
+      close();
+      return false;
+    }
+
+    // BGR ɕϊɓ]łftH[}bgm߂
+    //   VF[_͈͌͂ BT.601 Ƃĕϊ̂ŁAtW (YUVJ420P Ȃ) ͈̂̂ȂB
+    width = codecContext->width;
+    height = codecContext->height;
+    if (codecContext->color_range == AVCOL_RANGE_JPEG)
+    {
+      close();
+      return false;
+    }
+    switch (codecContext->pix_fmt)
+    {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_NV12:
+      // Px̉ (U, V) ̑gɂFu
+      format = GL_RED;
+      chromaOffset = static_cast<GLsizeiptr>(width) * height;
+      break;
+
+    case AV_PIX_FMT_YUYV422:
+      format = GL_RG;
+      break;
+
+    default:
+      // ȂftH[}bg
+      close();
+      return false;
+    }
+
+    // Xg[̎̒Pʂƃt[̊Ԋu
+    timeBase = av_q2d(video->time_base);
+    const double fps(av_q2d(video->avg_frame_rate));
+    interval = fps > 0.0 ? 1.0 / fps : 1.0 / 30.0;
+
+    // fR[ht[Ɠǂݍ񂾃pPbg
+    frame = av_frame_alloc();
+    packet = av_packet_alloc();
+
+    // Lv`p̃mۂ
+    allocate();
+
+    // ŏ̃t[fR[hĕ`Xbhɓn
+    if (!receive())
+    {
+      close();
+      return false;
+    }
+    store();
+    origin = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp * timeBase : 0.0));
+    publish(getFrameTime());
+
+    return true;
+  }
+};
@@ -0,0 +1,426 @@
+#pragma once
+
+//
+// ̃t[̋L^ƍĐ
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// t@C̃ւ̃}bv
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+// WCu
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+//
+// ̃t[L^t@Č`
+//   擪̃y[WɃwb_ÂƂɃy[WEɑt[ׁAŌɃt[̍uB
+//   t[̓Lv`Ƃ̃̓ê܂܂Ȃ̂ŁAĐƂ̓}bvt@C
+//   ̂܂܃t[̃ɎgBlׂ͂ċL^}ṼoCgŊi[B
+//
+
+// t@C̃wb_
+struct RawHeader
+{
+  // t@C̎ʎq "FISHRAW1"
+  char magic[8];
+
+  // 摜̕ƍ
+  uint32_t width, height;
+
+  // 摜̃tH[}bg
+  uint32_t format;
+
+  // 摜 1 s̉f (0 Ȃ畝Ɠ)
+  int32_t rowLength;
+
+  // F̕ʂ̃t[̐擪̃oCgʒu (0 ȂF̕ʂ͂Ȃ)
+  uint64_t chromaOffset;
+
+  // 1 t[̃oCg
+  uint64_t frameSize;
+
+  // t[̐
+  uint64_t count;
+
+  // ̃t@C̐擪̃oCgʒu (0 ȂL^IĂȂ)
+  uint64_t index;
+};
+
+// t[̍
+struct RawIndex
+{
+  // t[̃t@C̐擪̃oCgʒu
+  uint64_t offset;
+
+  // ŏ̃t[̎ (imb)
+  int64_t time;
+};
+
+// t[𑵂y[W̑傫
+constexpr uint64_t rawPageSize(4096);
+
+//
+// Lv`t[L^NX
+//   J setRecorder() ɓnƁALv`Xbh`Xbhɓnt[
+//   ׂăt@CɏށBJ̃Xbh~Ă close() B
+//
+class RawRecorder
+  : public Camera::Recorder
+{
+  // Rs[RXgN^𕕂
+  RawRecorder(const RawRecorder &c);
+
+  // 𕕂
+  RawRecorder &operator=(const RawRecorder &w);
+
+  // L^t@C
+  FILE *file;
+
+  // t@C̃wb_
+  RawHeader header;
+
+  // t[̍
+  std::vector<RawIndex> index;
+
+  // ̃t[ރoCgʒu
+  uint64_t offset;
+
+  // 1 t[݂̏ɎgoCg (y[WEɑ)
+  uint64_t stride;
+
+  // ŏ̃t[̎
+  std::chrono::steady_clock::time_point first;
+
+  // ݂Ɏs true
+  bool failed;
+
+  // t@C݈̏ʒuړ (2GB 𒴂ʒuɂړ)
+  int seek(uint64_t position)
+  {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(position), SEEK_SET);
+#else
+    return fseeko(file, static_cast<off_t>(position), SEEK_SET);
+#endif
+  }
+
+  // 0 Ŗ߂f[^
+  bool pad(uint64_t size)
+  {
+    static const char zero[rawPageSize] = {};
+    while (size > 0)
+    {
+      const size_t n(static_cast<size_t>(std::min(size, rawPageSize)));
+      if (fwrite(zero, 1, n, file) != n) return false;
+      size -= n;
+    }
+    return true;
+  }
+
+public:
+
+  // RXgN^
+  RawRecorder()
+    : file(nullptr), offset(0), stride(0), failed(false)
+  {}
+
+  // fXgN^
+  virtual ~RawRecorder()
+  {
+    close();
+  }
+
+  // L^Jn
+  //   filename ͋L^t@CAcamera ͋L^J (JĂw肷)
+  bool open(const std::string &filename, const Camera &camera)
+  {
+    close();
+
+    file = fopen(filename.c_str(), "wb");
+    if (!file) return false;
+
+    // wb_ݒ肷
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, "FISHRAW1", sizeof header.magic);
+    header.width = camera.getWidth();
+    header.height = camera.getHeight();
+    header.format = camera.getFormat();
+    header.rowLength = camera.getRowLength();
+    header.chromaOffset = camera.getChromaOffset();
+    header.frameSize = camera.getFrameSize();
+
+    // t[̓wb_̃y[W̌납y[WEɑĒu
+    stride = (header.frameSize + rawPageSize - 1) / rawPageSize * rawPageSize;
+    offset = rawPageSize;
+    index.clear();
+    failed = false;
+
+    // L^IĂȂwb_ł
+    if (fwrite(&header, sizeof header, 1, file) != 1 || !pad(rawPageSize - sizeof header))
+    {
+      fclose(file);
+      file = nullptr;
+      return false;
+    }
+
+    return true;
+  }
+
+  // t[L^
+  virtual void record(const GLubyte *frame, std::chrono::steady_clock::time_point time)
+  {
+    if (!file || failed) return;
+
+    // ŏ̃t[̎
+    if (index.empty()) first = time;
+    const RawIndex entry = { offset, std::chrono::duration_cast<std::chrono::nanoseconds>(time - first).count() };
+
+    // t[ƃy[WE܂ł̋lߕ
+    if (fwrite(frame, 1, static_cast<size_t>(header.frameSize), file) != header.frameSize
+      || !pad(stride - header.frameSize))
+    {
+      // ߂Ȃ炻܂ł̃t[c
+      failed = true;
+      return;
+    }
+
+    index.push_back(entry);
+    offset += stride;
+  }
+
+  // L^I
+  //   ݁Awb_XVB
+  void close()
+  {
+    if (!file) return;
+
+    // Ō̃t[̌ɍ (݂Ɏst[͏㏑)
+    header.count = index.size();
+    header.index = offset;
+    if (seek(offset) != 0 || fwrite(index.data(), sizeof(RawIndex), index.size(), file) != index.size())
+    {
+      // ߂Ȃ΋L^IĂȂƂɂ
+      header.index = 0;
+    }
+
+    // wb_XV
+    seek(0);
+    fwrite(&header, sizeof header, 1, file);
+    fclose(file);
+    file = nullptr;
+  }
+
+  // L^t[̐𓾂
+  size_t getCount() const
+  {
+    return index.size();
+  }
+};
+
+//
+// L^t[ĐNX
+//   t@CɃ}bvAt[𕡎ʂfR[hɂ̂܂ܕ`XbhɓnB
+//
+class CamRaw
+  : public Camera
+{
+  // }bvt@C
+#if defined(_WIN32)
+  HANDLE file, mapping;
+#else
+  int file;
+#endif
+
+  // t@C}bvƂ̃oCg
+  const GLubyte *memory;
+  size_t length;
+
+  // t[̍ƃt[̐
+  const RawIndex *index;
+  size_t count;
+
+  // L^ɍ킹čĐȂ true
+  bool paced;
+
+  // 擪̃t[n
+  std::chrono::steady_clock::time_point origin;
+
+  // t[̊Ԋu (b)
+  double interval;
+
+  // frame Ԗڂ̃t[̎𓾂
+  std::chrono::steady_clock::time_point getFrameTime(size_t frame) const
+  {
+    return origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(index[frame].time));
+  }
+
+  // t@CɃ}bv
+  bool map(const std::string &filename)
+  {
+#if defined(_WIN32)
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+    length = static_cast<size_t>(size.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return false;
+    memory = static_cast<const GLubyte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    return memory != nullptr;
+#else
+    file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    if (fstat(file, &status) < 0 || status.st_size == 0) return false;
+    length = static_cast<size_t>(status.st_size);
+    void *const address(mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0));
+    if (address == MAP_FAILED) return false;
+    memory = static_cast<const GLubyte *>(address);
+
+    // ǂ݂ĂĂ炤
+    posix_madvise(address, length, POSIX_MADV_WILLNEED);
+    return true;
+#endif
+  }
+
+  // t@C̃}bv
+  void unmap()
+  {
+#if defined(_WIN32)
+    if (memory) UnmapViewOfFile(memory);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#else
+    if (memory) munmap(const_cast<GLubyte *>(memory), length);
+    if (file >= 0) ::close(file);
+    file = -1;
+#endif
+    memory = nullptr;
+    length = 0;
+  }
+
+  // t[Đ
+  virtual void capture()
+  {
+    // 擪̃t[ open() œnĂ
+    size_t frame(0);
+
+    // Xbhs̊
+    while (run)
+    {
+      // ̃t[ɐi݁AŌ̃t[̎͐擪ɖ߂ (ꊇϊȂI)
+      if (++frame >= count)
+      {
+        if (finish()) break;
+        origin = getFrameTime(count - 1) + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+        frame = 0;
+      }
+
+      // L^ɂȂ邩Õt[󂯎܂ő҂
+      const std::chrono::steady_clock::time_point due(getFrameTime(frame));
+      if (!wait(paced ? due : std::chrono::steady_clock::now(), !paced)) break;
+
+      // }bvt[̂܂ܕ`Xbhɓn
+      exchange(static_cast<int>(frame), paced ? due : std::chrono::steady_clock::now());
+    }
+  }
+
+public:
+
+  // RXgN^
+  CamRaw()
+#if defined(_WIN32)
+    : file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#else
+    : file(-1)
+#endif
+    , memory(nullptr), length(0), index(nullptr), count(0), paced(true), interval(1.0 / 30.0)
+  {}
+
+  // fXgN^
+  virtual ~CamRaw()
+  {
+    // Xbh~
+    stop();
+
+    // t@C̃}bv
+    unmap();
+  }
+
+  // L^t@CJ
+  //   paced  false ȂL^Ɋ֌WȂ`Xbh󂯎邽тɎ̃t[nB
+  bool open(const std::string &filename, bool paced = true)
+  {
+    // t@C}bv
+    if (!map(filename))
+    {
+      unmap();
+      return false;
+    }
+
+    // L^It@Cm߂
+    const RawHeader *const header(reinterpret_cast<const RawHeader *>(memory));
+    if (length < rawPageSize || memcmp(header->magic, "FISHRAW1", sizeof header->magic) != 0
+      || header->count == 0 || header->index == 0
+      || header->index + header->count * sizeof(RawIndex) > length)
+    {
+      unmap();
+      return false;
+    }
+
+    // ׂẴt[t@CɎ܂Ă邩m߂
+    index = reinterpret_cast<const RawIndex *>(memory + header->index);
+    count = static_cast<size_t>(header->count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (index[i].offset % rawPageSize != 0 || index[i].offset + header->frameSize > header->index)
+      {
+        unmap();
+        return false;
+      }
+    }
+
+    // 摜̌`
+    width = header->width;
+    height = header->height;
+    format = header->format;
+    rowLength = header->rowLength;
+    chromaOffset = static_cast<GLsizeiptr>(header->chromaOffset);
+
+    // }bvt[̂܂܃t[̃v[ɂ (OɖȂΌJԂ)
+    std::vector<GLubyte *> frames;
+    for (size_t i = 0; i < std::max(count, static_cast<size_t>(3)); ++i)
+      frames.push_back(const_cast<GLubyte *>(memory + index[i % count].offset));
+    attach(frames, static_cast<GLsizeiptr>(header->frameSize));
+
+    // Ō̃t[擪ɖ߂Ƃ̃t[̊Ԋu͕ς̃t[̊Ԋuɂ
+    if (count > 1) interval = index[count - 1].time * 1.0e-9 / (count - 1);
+    this->paced = paced;
+
+    // 擪̃t[`Xbhɓn
+    origin = std::chrono::steady_clock::now();
+    exchange(0, origin);
+
+    return true;
+  }
+
+  // L^t[̐𓾂
+  size_t getCount() const
+  {
+    return count;
+  }
+};
@@ -0,0 +1,482 @@
+#pragma once
+
+//
+// 摜ɂLv`
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// ʓWJ̐ݒꗗ
+#include "ExpansionShader.h"
+
+// WCu
+#include <cmath>
+#include <cstring>
+
+// Zp̊iqỸfœe摜𐶐NX
+//   iq͐Î~ƂčŏɈx`ĂAt[Ƃɂ𕡎ʂ
+//   ~Ղƃt[ԍ\Ȃd˂Bt[̓e̓t[ԍŌ܂B
+class CamSynthetic
+  : public Camera
+{
+public:
+
+  // Ỹf
+  enum Lens
+  {
+    PERSPECTIVE,        // ʏ̃J (fixed.vert, rectangle.vert)
+    FISHEYE,            // ˉe̋჌Y (fisheye.vert)
+    DUAL_FISHEYE,       // O̋჌Y (theta.vert)
+    EQUIRECTANGULAR     // ~}@ (panorama.vert)
+  };
+
+private:
+
+  // Ỹf
+  Lens lens;
+
+  // C[WT[N̔aƒSʒu
+  float circle[4];
+
+  // f̌`
+  CaptureColor color;
+
+  // t[̊Ԋu (b)
+  double interval;
+
+  // `Xbh󂯎邽тɎ̃t[nȂ true
+  bool unthrottled;
+
+  // t[ɕ`Zp̊iq̉摜 (t[Ɠ`)
+  std::vector<GLubyte> pattern;
+
+  // t[̐
+  unsigned long count;
+
+  // ŏ̃t[n
+  std::chrono::steady_clock::time_point origin;
+
+  // f̈ʒu王xNg v ߂
+  //   x, y ̓eNX`WAC[WT[N̊OȂ false ԂB
+  bool unproject(double x, double y, double *v) const
+  {
+    const double pi(3.14159265358979323846);
+    const double aspect(static_cast<double>(width) / height);
+
+    switch (lens)
+    {
+    case PERSPECTIVE:
+    {
+      // rectangle.vert ̋tϊ
+      const double s((x - 0.5 - circle[2]) * 2.0 * aspect * circle[0]);
+      const double t(-(y - 0.5 - circle[3]) * 2.0 * circle[1]);
+      const double l(sqrt(s * s + t * t + 1.0));
+      v[0] = s / l;
+      v[1] = t / l;
+      v[2] = -1.0 / l;
+      return true;
+    }
+
+    case FISHEYE:
+    {
+      // fisheye.vert ̋tϊ (S̋̊pxɔႷ)
+      const double s((x - 0.5 - circle[2]) * 2.0 * aspect * circle[0]);
+      const double t(-(y - 0.5 - circle[3]) * 2.0 * circle[1]);
+      const double angle(sqrt(s * s + t * t));
+      if (angle > circle[0]) return false;
+      const double r(angle > 0.0 ? sin(angle) / angle : 1.0);
+      v[0] = s * r;
+      v[1] = t * r;
+      v[2] = -cos(angle);
+      return true;
+    }
+
+    case DUAL_FISHEYE:
+    {
+      // theta.vert ̋tϊ ( (+Z)AEO (-Z) ̃Y)
+      const double rs(-0.25 * circle[0]), rt(0.25 * circle[1] * aspect);
+      const double cs(rs - circle[2] + 0.5), ct(rt - circle[3]);
+      const bool front(x >= 0.5);
+      const double s(front ? (x - cs - 0.5) / -rs : (x - cs) / rs);
+      const double t((y - ct) / rt);
+      const double k(sqrt(s * s + t * t));
+      if (k > 1.0) return false;
+      const double angle(k * pi / (2.0 * 0.885));
+      const double r(k > 0.0 ? sin(angle) / k : 0.0);
+      v[0] = t * r;
+      v[1] = s * r;
+      v[2] = front ? -cos(angle) : cos(angle);
+      return true;
+    }
+
+    default:
+    {
+      // panorama.frag ̋tϊ
+      const double longitude(-(x - 0.5 - circle[2]) * 2.0 * pi * circle[0]);
+      const double latitude(-(y - 0.5 - circle[3]) * pi * circle[1]);
+      if (fabs(latitude) > 0.5 * pi) return false;
+      v[0] = cos(latitude) * sin(longitude);
+      v[1] = sin(latitude);
+      v[2] = cos(latitude) * cos(longitude);
+      return true;
+    }
+    }
+  }
+
+  // xNg v ̕ʂf̈ʒu߂
+  //   position ɉf̈ʒui[A̐ (ʂȂ 0AÕYɎʂ 2) ԂB
+  int project(const double *v, int position[][2]) const
+  {
+    const double pi(3.14159265358979323846);
+    const double aspect(static_cast<double>(width) / height);
+    double tc[2][2];
+    int n(0);
+
+    switch (lens)
+    {
+    case PERSPECTIVE:
+      if (v[2] >= 0.0) return 0;
+      tc[0][0] = -v[0] / v[2] * 0.5 / (aspect * circle[0]) + 0.5 + circle[2];
+      tc[0][1] = v[1] / v[2] * 0.5 / circle[1] + 0.5 + circle[3];
+      n = 1;
+      break;
+
+    case FISHEYE:
+    {
+      const double angle(acos(std::max(-1.0, std::min(-v[2], 1.0))));
+      if (angle > circle[0]) return 0;
+      const double l(sqrt(v[0] * v[0] + v[1] * v[1]));
+      const double r(l > 0.0 ? angle / l : 0.0);
+      tc[0][0] = v[0] * r * 0.5 / (aspect * circle[0]) + 0.5 + circle[2];
+      tc[0][1] = -v[1] * r * 0.5 / circle[1] + 0.5 + circle[3];
+      n = 1;
+      break;
+    }
+
+    case DUAL_FISHEYE:
+    {
+      const double rs(-0.25 * circle[0]), rt(0.25 * circle[1] * aspect);
+      const double cs(rs - circle[2] + 0.5), ct(rt - circle[3]);
+      const double angle(1.0 - acos(std::max(-1.0, std::min(v[2], 1.0))) * 2.0 / pi);
+      const double l(sqrt(v[0] * v[0] + v[1] * v[1]));
+      const double os(l > 0.0 ? v[1] / l * 0.885 : 0.0), ot(l > 0.0 ? v[0] / l * 0.885 : 0.0);
+
+      // ̃YɎʂ邩
+      if ((1.0 - angle) * 0.885 <= 1.0)
+      {
+        tc[n][0] = (1.0 - angle) * os * rs + cs;
+        tc[n][1] = (1.0 - angle) * ot * rt + ct;
+        ++n;
+      }
+
+      // ÕYɎʂ邩
+      if ((1.0 + angle) * 0.885 <= 1.0)
+      {
+        tc[n][0] = (1.0 + angle) * os * -rs + cs + 0.5;
+        tc[n][1] = (1.0 + angle) * ot * rt + ct;
+        ++n;
+      }
+      break;
+    }
+
+    default:
+      tc[0][0] = -atan2(v[0], v[2]) / (2.0 * pi * circle[0]) + 0.5 + circle[2];
+      tc[0][1] = -asin(std::max(-1.0, std::min(v[1], 1.0))) / (pi * circle[1]) + 0.5 + circle[3];
+      n = 1;
+      break;
+    }
+
+    // eNX`Wf̈ʒuɂ
+    for (int i = 0; i < n; ++i)
+    {
+      position[i][0] = static_cast<int>(floor(tc[i][0] * width));
+      position[i][1] = static_cast<int>(floor(tc[i][1] * height));
+    }
+
+    return n;
+  }
+
+  // xNg v ̍̕Zp̊iq̐F BGR ŋ߂
+  //   15ƂɌoƈܐAox 0Ɛԓ͐Ԃő`B
+  //   ڂ͌ox 90ƂɐFςAk𖾂邭B
+  static void grid(const double *v, GLubyte *bgr)
+  {
+    const double degree(180.0 / 3.14159265358979323846);
+    const double longitude(atan2(v[0], -v[2]) * degree);
+    const double latitude(asin(std::max(-1.0, std::min(v[1], 1.0))) * degree);
+
+    // ł߂܂ł̊px
+    const double dl(fabs(longitude - 15.0 * floor(longitude / 15.0 + 0.5)) * cos(latitude / degree));
+    const double db(fabs(latitude - 15.0 * floor(latitude / 15.0 + 0.5)));
+
+    // ox 0Ɛԓ
+    if (fabs(longitude) * cos(latitude / degree) < 0.8 || fabs(latitude) < 0.8)
+    {
+      bgr[0] = bgr[1] = 32;
+      bgr[2] = 224;
+      return;
+    }
+
+    // ̂ق̌oƈܐ
+    if (dl < 0.4 || db < 0.4)
+    {
+      bgr[0] = bgr[1] = bgr[2] = 224;
+      return;
+    }
+
+    // ڂ̐F (OAEAȀ)
+    static const GLubyte hue[][3] = { { 160, 96, 64 }, { 64, 160, 64 }, { 64, 64, 160 }, { 32, 160, 160 } };
+    const int quadrant(static_cast<int>(floor((longitude + 405.0) / 90.0)) % 4);
+    const bool checker((static_cast<int>(floor(longitude / 15.0)) + static_cast<int>(floor(latitude / 15.0))) & 1);
+    const int scale((latitude > 0.0 ? 4 : 2) + (checker ? 1 : 0));
+    for (int i = 0; i < 3; ++i) bgr[i] = static_cast<GLubyte>(hue[quadrant][i] * scale / 5);
+  }
+
+  // Zp̊iq̉摜t[̌`ō쐬
+  void render()
+  {
+    // BGR ŕ`
+    std::vector<GLubyte> bgr(static_cast<size_t>(width) * height * 3, 0);
+    for (int y = 0; y < height; ++y)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        double v[3];
+        if (unproject((x + 0.5) / width, (y + 0.5) / height, v))
+          grid(v, bgr.data() + (static_cast<size_t>(y) * width + x) * 3);
+      }
+    }
+
+    // BGR Ȃ炻̂܂܎g
+    if (color == CAPTURE_BGR)
+    {
+      pattern.swap(bgr);
+      return;
+    }
+
+    // BT.601 ̋PxƐFɕϊ
+    const size_t pixels(static_cast<size_t>(width) * height);
+    pattern.assign(color == CAPTURE_YUYV ? pixels * 2 : pixels + pixels / 2, 0);
+    for (int y = 0; y < height; ++y)
+    {
+      for (int x = 0; x < width; x += 2)
+      {
+        // ɕ񂾓̉f
+        const GLubyte *const p(bgr.data() + (static_cast<size_t>(y) * width + x) * 3);
+        double luma[2], u(0.0), v(0.0);
+        for (int i = 0; i < 2; ++i)
+        {
+          const double b(p[i * 3] / 255.0), g(p[i * 3 + 1] / 255.0), r(p[i * 3 + 2] / 255.0);
+          luma[i] = 16.0 + 65.481 * r + 128.553 * g + 24.966 * b;
+          u += 0.5 * (128.0 - 37.797 * r - 74.203 * g + 112.0 * b);
+          v += 0.5 * (128.0 + 112.0 * r - 93.786 * g - 18.214 * b);
+        }
+
+        if (color == CAPTURE_YUYV)
+        {
+          // (Y, U), (Y, V) ̑gɂ
+          GLubyte *const q(pattern.data() + (static_cast<size_t>(y) * width + x) * 2);
+          q[0] = static_cast<GLubyte>(luma[0] + 0.5);
+          q[1] = static_cast<GLubyte>(u + 0.5);
+          q[2] = static_cast<GLubyte>(luma[1] + 0.5);
+          q[3] = static_cast<GLubyte>(v + 0.5);
+        }
+        else
+        {
+          // Px̕ʂƏc (U, V) ̑g̕ʂɂ (F͋s)
+          GLubyte *const q(pattern.data() + static_cast<size_t>(y) * width + x);
+          q[0] = static_cast<GLubyte>(luma[0] + 0.5);
+          q[1] = static_cast<GLubyte>(luma[1] + 0.5);
+          if ((y & 1) == 0)
+          {
+            GLubyte *const uv(pattern.data() + pixels + static_cast<size_t>(y / 2) * width + x);
+            uv[0] = static_cast<GLubyte>(u + 0.5);
+            uv[1] = static_cast<GLubyte>(v + 0.5);
+          }
+        }
+      }
+    }
+  }
+
+  // t[̉fDFɂ
+  //   value ͋Px (16 ` 235)
+  void gray(GLubyte *buffer, int x, int y, GLubyte value) const
+  {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    const size_t pixel(static_cast<size_t>(y) * width + x);
+
+    switch (color)
+    {
+    case CAPTURE_YUYV:
+      buffer[pixel * 2] = value;
+      buffer[pixel * 2 + 1] = 128;
+      break;
+
+    case CAPTURE_NV12:
+      buffer[pixel] = value;
+      buffer[static_cast<size_t>(width) * height + static_cast<size_t>(y / 2) * width + (x & ~1)] = 128;
+      buffer[static_cast<size_t>(width) * height + static_cast<size_t>(y / 2) * width + (x & ~1) + 1] = 128;
+      break;
+
+    default:
+      buffer[pixel * 3] = buffer[pixel * 3 + 1] = buffer[pixel * 3 + 2] = value;
+      break;
+    }
+  }
+
+  // xNg v ̕ɉ~Ղ`
+  void disc(GLubyte *buffer, const double *v, GLubyte value) const
+  {
+    // ~Ղ̔a
+    const int radius(std::max(3, height / 48));
+
+    int position[2][2];
+    const int n(project(v, position));
+    for (int i = 0; i < n; ++i)
+      for (int y = -radius; y <= radius; ++y)
+        for (int x = -radius; x <= radius; ++x)
+          if (x * x + y * y <= radius * radius) gray(buffer, position[i][0] + x, position[i][1] + y, value);
+  }
+
+  // frame Ԗڂ̃t[𐶐
+  void generate(GLubyte *buffer, unsigned long frame) const
+  {
+    const double pi(3.14159265358979323846);
+
+    // Zp̊iq𕡎ʂ
+    memcpy(buffer, pattern.data(), pattern.size());
+
+    // t[̎ (b)
+    const double t(frame * interval);
+
+    //  4 bň锒~
+    const double a(2.0 * pi * t / 4.0);
+    const double h[] = { sin(a), 0.0, -cos(a) };
+    disc(buffer, h, 235);
+
+    // Vʂ 6 bň鍕~
+    const double b(2.0 * pi * t / 6.0);
+    const double p[] = { 0.0, sin(b), -cos(b) };
+    disc(buffer, p, 16);
+
+    // Ƀt[ԍ̉ 32 rbgʂ珇ɔ̏ڂŕ`
+    const int block(getBlockSize());
+    for (int bit = 0; bit < 32; ++bit)
+    {
+      const GLubyte value((frame >> bit) & 1 ? 235 : 16);
+      for (int y = 0; y < block; ++y)
+        for (int x = 0; x < block; ++x)
+          gray(buffer, bit * block + x, y, value);
+    }
+  }
+
+  // t[𐶐
+  virtual void capture()
+  {
+    // Xbhs̊
+    while (run)
+    {
+      // ̃t[𐶐
+      const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+      generate(getBackBuffer(), count);
+      countDecode(start);
+
+      // t[̎ɂȂ邩Õt[󂯎܂ő҂
+      const std::chrono::steady_clock::time_point due(origin
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(count * interval)));
+      if (!wait(unthrottled ? std::chrono::steady_clock::now() : due, unthrottled)) break;
+
+      // `Xbhɓn
+      publish(unthrottled ? std::chrono::steady_clock::now() : due);
+      ++count;
+    }
+  }
+
+public:
+
+  // RXgN^
+  CamSynthetic()
+    : lens(FISHEYE), circle{ 1.0f, 1.0f, 0.0f, 0.0f }, color(CAPTURE_BGR)
+    , interval(1.0 / 30.0), unthrottled(false), count(0)
+  {}
+
+  // fXgN^
+  virtual ~CamSynthetic()
+  {
+    // Xbh~
+    stop();
+  }
+
+  // ʓWJɎgo[ebNXVF[_̃\[Xt@C烌Ỹf𓾂
+  static Lens getLens(const char *vsrc)
+  {
+    if (strcmp(vsrc, "fisheye.vert") == 0) return FISHEYE;
+    if (strcmp(vsrc, "theta.vert") == 0) return DUAL_FISHEYE;
+    if (strcmp(vsrc, "panorama.vert") == 0) return EQUIRECTANGULAR;
+    return PERSPECTIVE;
+  }
+
+  // 摜̐Jn
+  //   lens ̓ỸfAcircle ̓C[WT[N̔aƒSʒuAcolor ͉f̌`B
+  //   fps  0 ȉȂ`Xbht[󂯎邽тɎ̃t[nB
+  bool open(Lens lens, const float *circle, CaptureColor color, int width, int height, double fps)
+  {
+    // YUV ͉ (NV12 ͏c) fŐFL
+    if (width <= 0 || height <= 0 || (color != CAPTURE_BGR && (width & 1))
+      || (color == CAPTURE_NV12 && (height & 1))) return false;
+
+    this->lens = lens;
+    std::copy(circle, circle + 4, this->circle);
+    this->color = color;
+    this->width = width;
+    this->height = height;
+    unthrottled = fps <= 0.0;
+    interval = unthrottled ? 1.0 / 30.0 : 1.0 / fps;
+
+    // f̌`
+    switch (color)
+    {
+    case CAPTURE_YUYV:
+      format = GL_RG;
+      break;
+
+    case CAPTURE_NV12:
+      format = GL_RED;
+      chromaOffset = static_cast<GLsizeiptr>(width) * height;
+      break;
+
+    default:
+      format = GL_BGR;
+      break;
+    }
+
+    // Lv`p̃mۂ
+    allocate();
+
+    // Zp̊iq`
+    render();
+
+    // ŏ̃t[`Xbhɓn
+    count = 0;
+    generate(getBackBuffer(), count++);
+    origin = std::chrono::steady_clock::now();
+    publish(origin);
+
+    return true;
+  }
+
+  // ʓWJ̐ݒɍ킹摜̐Jn
+  //   width, height  0 Ȃݒ̉𑜓xɂB
+  bool open(const ExpansionShader &shader, double fps, int width = 0, int height = 0)
+  {
+    return open(getLens(shader.vsrc), shader.circle, shader.color,
+      width > 0 ? width : shader.width, height > 0 ? height : shader.height, fps);
+  }
+
+  // t[ԍ\ڂ̈ӂ̉f𓾂
+  int getBlockSize() const
+  {
+    return std::max(2, width / 128);
+  }
+};
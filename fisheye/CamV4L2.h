@@ -0,0 +1,474 @@
+#pragma once
+
+//
+// Video4Linux2 gLv` (Linux p)
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// OpenCV (MJPEG ̓WJɎg)
+#include <opencv2/highgui/highgui.hpp>
+
+// Video4Linux2
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+// WCu
+#include <deque>
+
+// Video4Linux2 ̃obt@𒼐ڃt[ɂăLv`NX
+//   YUYV  NV12 ̓foCX̃obt@̂܂܃eNX`ɓ]B
+//   YUYV  1 f (Y, U) ܂ (Y, V)  GL_RG ŁANV12 ͋Px GL_RED ŁA
+//   Fc GL_RG œ]BMJPEG ͓WJ GL_BGR œ]B
+class CamV4L2
+  : public Camera
+{
+  // Lv`foCX̃t@CLqq
+  int fd;
+
+  // Lv`foCX̉ftH[}bg
+  __u32 fourcc;
+
+  // Lv`foCX̃t[[g
+  double fps;
+
+  // foCX̃obt@ʑƂ̑傫
+  std::vector<std::pair<void *, size_t>> mapped;
+
+  // Đt@CʑƂ̑傫 (Lv`foCX̑)
+  const GLubyte *replayMemory;
+  size_t replaySize;
+
+  // Đt@C̃t[ƎɍĐt[
+  size_t replayCount, replayIndex;
+
+  // Đt@C̎̃t[̎
+  std::chrono::steady_clock::time_point replayDue;
+
+  // Đt@CŃfoCX̃L[̑Ɏg҂s
+  std::deque<int> replayQueue;
+
+  // 1 t[̃oCg
+  size_t imageSize;
+
+  // 荞܂Ă ioctl 蒼
+  int xioctl(unsigned long request, void *arg) const
+  {
+    int result;
+    do result = ioctl(fd, request, arg); while (result < 0 && errno == EINTR);
+    return result;
+  }
+
+  // ftH[}bgɍ킹ăeNX`ɓ]摜̃TCYƃtH[}bg߂
+  //   bytesperline  1 s̃oCg (0 ȂlߕȂ)
+  bool setFormat(__u32 pixelformat, int image_width, int image_height, int bytesperline)
+  {
+    fourcc = pixelformat;
+    width = image_width;
+    height = image_height;
+    chromaOffset = 0;
+
+    switch (fourcc)
+    {
+    case V4L2_PIX_FMT_YUYV:
+      // Y0 U0 Y1 V0  (Y0, U0), (Y1, V0) ̓̉fƂē]
+      format = GL_RG;
+      rowLength = bytesperline > 0 ? bytesperline / 2 : 0;
+      return true;
+
+    case V4L2_PIX_FMT_NV12:
+      // Px̕ʂ̉ɐF̕ʂ
+      format = GL_RED;
+      rowLength = bytesperline > 0 ? bytesperline : 0;
+      chromaOffset = static_cast<GLsizeiptr>(bytesperline > 0 ? bytesperline : image_width) * image_height;
+      return true;
+
+    case V4L2_PIX_FMT_GREY:
+      format = GL_RED;
+      rowLength = bytesperline > 0 ? bytesperline : 0;
+      return true;
+
+    case V4L2_PIX_FMT_MJPEG:
+      // WJ摜]
+      format = GL_BGR;
+      rowLength = 0;
+      return true;
+
+    default:
+      break;
+    }
+
+    // ȂftH[}bg
+    return false;
+  }
+
+  // t[̃v[pӂăobt@L[ɓ
+  //   memory ̓foCX̃obt@Asize  1 t[̃oCg
+  void prepare(const std::vector<GLubyte *> &memory, size_t size)
+  {
+    imageSize = size;
+
+    if (fourcc == V4L2_PIX_FMT_MJPEG)
+    {
+      // MJPEG ͓WJt[]̂Ńt[̃ʂɊmۂ
+      allocate();
+
+      // ׂẴobt@L[ɓ
+      for (size_t i = 0; i < memory.size(); ++i) enqueue(static_cast<int>(i));
+    }
+    else
+    {
+      // foCX̃obt@̂܂܃t[̃v[ɂ
+      attach(memory, static_cast<GLsizeiptr>(size));
+
+      // obt@L[ɓ
+      enqueueAll();
+    }
+  }
+
+  // `Xbh̓]pƎ󂯓np (1 Ԃ 2 ) ȊÕt[̃obt@L[ɓ
+  void enqueueAll()
+  {
+    for (int i = 0; i < getFrameCount(); ++i) if (i != 1 && i != 2) enqueue(i);
+  }
+
+  // obt@L[ɖ߂
+  void enqueue(int index)
+  {
+    if (replayMemory)
+    {
+      replayQueue.push_back(index);
+    }
+    else
+    {
+      v4l2_buffer buffer = {};
+      buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buffer.memory = V4L2_MEMORY_MMAP;
+      buffer.index = index;
+      xioctl(VIDIOC_QBUF, &buffer);
+    }
+  }
+
+  // t[܂ꂽobt@L[o
+  //   t[o 1A܂Ȃ 0AG[Ȃ -1 ԂB
+  int dequeue(int &index, size_t &bytes, std::chrono::steady_clock::time_point &time)
+  {
+    if (replayMemory)
+    {
+      // t[̎܂ő҂
+      if (!wait(replayDue, false)) return 0;
+
+      // t@C̍ŌɒB擪ɖ߂
+      if (replayIndex >= replayCount) replayIndex = 0;
+
+      // L[Ƀobt@Ȃ΃foCXƓ悤Ƀt[𗎂ƂĎ̃t[̎ɐi
+      //   ꊇϊł̓t[𗎂ƂɃobt@߂̂҂B
+      if (replayQueue.empty())
+      {
+        if (!isBatch())
+        {
+          ++replayIndex;
+          replayDue += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fps));
+        }
+        return 0;
+      }
+
+      // foCX̑Ƀt@C̃t[obt@ɏ
+      index = replayQueue.front();
+      replayQueue.pop_front();
+      const GLubyte *const frame(replayMemory + imageSize * replayIndex++);
+      std::copy(frame, frame + imageSize, getFrame(index));
+
+      // t[̎
+      bytes = imageSize;
+      time = replayDue;
+      replayDue += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / fps));
+      return 1;
+    }
+
+    // t[͂̂҂ (Xbh̒~m߂邽 100ms ňU߂)
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    timeval timeout = { 0, 100000 };
+    const int ready(select(fd + 1, &fds, nullptr, nullptr, &timeout));
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+    if (ready == 0) return 0;
+
+    // t[܂ꂽobt@o
+    v4l2_buffer buffer = {};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_DQBUF, &buffer) < 0) return errno == EAGAIN ? 0 : -1;
+    index = buffer.index;
+    bytes = buffer.bytesused;
+
+    // hCo CLOCK_MONOTONIC ̃^CX^vtĂ΂t[̎ɂ
+    if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+      time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::seconds(buffer.timestamp.tv_sec) + std::chrono::microseconds(buffer.timestamp.tv_usec)));
+    else
+      time = std::chrono::steady_clock::now();
+
+    return 1;
+  }
+
+  // MJPEG ̃t[WJăLv`Xbhރt[ɐ؂o
+  bool decode(const GLubyte *data, size_t bytes)
+  {
+    // kꂽt[ cv::Mat ƂĈ
+    const cv::Mat jpeg(1, static_cast<int>(bytes), CV_8UC1, const_cast<GLubyte *>(data));
+
+    // Lv`Xbhރt[̃ɓWJ
+    cv::Mat frame(height, width, CV_8UC3, getBackBuffer());
+    cv::imdecode(jpeg, 1, &frame);
+
+    // WJt[̃TCYقȂămۂꂽ畡ʂ
+    if (frame.data != getBackBuffer())
+    {
+      if (frame.total() != static_cast<size_t>(width * height)) return false;
+      std::copy(frame.data, frame.data + frame.total() * frame.elemSize(), getBackBuffer());
+    }
+
+    return true;
+  }
+
+  // t[Lv`
+  //   foCX̃obt@󂯓np̃t[ƌAɕԂꂽobt@L[ɖ߂B
+  //   `Xbh̓foCX̃obt@璼ڃeNX`ɓ]̂ŕʂ͐ȂB
+  virtual void capture()
+  {
+    // Xbhs̊
+    while (run)
+    {
+      // ꊇϊōĐt@C̍Ō̃t[܂œnI犪߂ɏI
+      if (replayMemory && replayIndex >= replayCount && finish()) break;
+
+      // t[܂ꂽobt@o
+      int index;
+      size_t bytes;
+      std::chrono::steady_clock::time_point time;
+      const int status(dequeue(index, bytes, time));
+
+      // G[ȂLv`foCX񕜂̂҂
+      if (status < 0 && !wait(std::chrono::steady_clock::now() + std::chrono::milliseconds(10L), false)) break;
+      if (status <= 0) continue;
+
+      if (fourcc == V4L2_PIX_FMT_MJPEG)
+      {
+        // MJPEG ȂWJăobt@L[ɖ߂
+        const bool decoded(decode(static_cast<const GLubyte *>(mapped[index].first), bytes));
+        enqueue(index);
+
+        // `Xbhɓn
+        if (decoded) publish(time);
+      }
+      else
+      {
+        // obt@`XbhɓnAɕԂꂽobt@L[ɖ߂
+        enqueue(exchange(index, time));
+      }
+    }
+  }
+
+  // Lv`foCXĐt@C
+  void close()
+  {
+    if (replayMemory)
+    {
+      munmap(const_cast<GLubyte *>(replayMemory), replaySize);
+      replayMemory = nullptr;
+      replayQueue.clear();
+    }
+
+    if (fd >= 0)
+    {
+      // Xg[~O~
+      v4l2_buf_type type(V4L2_BUF_TYPE_VIDEO_CAPTURE);
+      xioctl(VIDIOC_STREAMOFF, &type);
+
+      // obt@̎ʑ
+      for (auto &m : mapped) munmap(m.first, m.second);
+      mapped.clear();
+
+      // Lv`foCX
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+public:
+
+  // RXgN^
+  CamV4L2()
+    : fd(-1), fourcc(0), fps(0.0), replayMemory(nullptr), replaySize(0)
+    , replayCount(0), replayIndex(0), imageSize(0)
+  {}
+
+  // fXgN^
+  virtual ~CamV4L2()
+  {
+    // Xbh~
+    stop();
+
+    // Lv`foCX
+    close();
+  }
+
+  // Lv`foCX͂
+  //   device ̓foCXt@CApixelformat  V4L2_PIX_FMT_YUYV Ȃǂ̉ftH[}bgA
+  //   buffers ̓foCXɗvobt@̐ (`Xbhg܂߂Ďlȏ)
+  bool open(const char *device, __u32 pixelformat, int initial_width, int initial_height, int initial_fps = 0, int buffers = 6)
+  {
+    // Lv`foCXJ
+    fd = ::open(device, O_RDWR | O_NONBLOCK);
+    if (fd < 0) return false;
+
+    // Xg[~OŃLv`ł邩m߂
+    v4l2_capability capability = {};
+    if (xioctl(VIDIOC_QUERYCAP, &capability) < 0)
+    {
+      close();
+      return false;
+    }
+    const __u32 caps((capability.capabilities & V4L2_CAP_DEVICE_CAPS) ? capability.device_caps : capability.capabilities);
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING))
+    {
+      close();
+      return false;
+    }
+
+    // ftH[}bgƉ𑜓xw肵āAhCoI񂾂̂m߂
+    v4l2_format fmt = {};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = initial_width;
+    fmt.fmt.pix.height = initial_height;
+    fmt.fmt.pix.pixelformat = pixelformat;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(VIDIOC_S_FMT, &fmt) < 0 || fmt.fmt.pix.pixelformat != pixelformat)
+    {
+      close();
+      return false;
+    }
+    if (!setFormat(pixelformat, fmt.fmt.pix.width, fmt.fmt.pix.height,
+      pixelformat == V4L2_PIX_FMT_MJPEG ? 0 : fmt.fmt.pix.bytesperline))
+    {
+      close();
+      return false;
+    }
+
+    // t[[gw肵āAhCoI񂾂̂m߂
+    v4l2_streamparm parm = {};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (initial_fps > 0)
+    {
+      parm.parm.capture.timeperframe.numerator = 1;
+      parm.parm.capture.timeperframe.denominator = initial_fps;
+      xioctl(VIDIOC_S_PARM, &parm);
+    }
+    if (xioctl(VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0)
+      fps = static_cast<double>(parm.parm.capture.timeperframe.denominator) / parm.parm.capture.timeperframe.numerator;
+
+    // obt@v
+    v4l2_requestbuffers request = {};
+    request.count = std::max(buffers, 4);
+    request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_REQBUFS, &request) < 0 || request.count < 4)
+    {
+      close();
+      return false;
+    }
+
+    // obt@ʑ
+    std::vector<GLubyte *> memory;
+    for (__u32 i = 0; i < request.count; ++i)
+    {
+      v4l2_buffer buffer = {};
+      buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buffer.memory = V4L2_MEMORY_MMAP;
+      buffer.index = i;
+      if (xioctl(VIDIOC_QUERYBUF, &buffer) < 0)
+      {
+        close();
+        return false;
+      }
+
+      void *const address(mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset));
+      if (address == MAP_FAILED)
+      {
+        close();
+        return false;
+      }
+      mapped.emplace_back(address, buffer.length);
+      memory.push_back(static_cast<GLubyte *>(address));
+    }
+
+    // t[̃v[pӂăobt@L[ɓ
+    prepare(memory, fmt.fmt.pix.sizeimage);
+
+    // Xg[~OJn
+    v4l2_buf_type type(V4L2_BUF_TYPE_VIDEO_CAPTURE);
+    if (xioctl(VIDIOC_STREAMON, &type) < 0)
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  // Lv`foCX̑ɐ̃t[ׂt@C͂
+  //   foCXƓ悤Ƀobt@L[ɏoꂷ̂ŁA@ȂĂłB
+  //   pixelformat  V4L2_PIX_FMT_YUYV Ȃǂ̉ftH[}bg (MJPEG ͎gȂ)
+  bool replay(const char *file, __u32 pixelformat, int initial_width, int initial_height, int initial_fps = 30, int buffers = 6)
+  {
+    // ftH[}bgݒ肷
+    if (pixelformat == V4L2_PIX_FMT_MJPEG || !setFormat(pixelformat, initial_width, initial_height, 0)) return false;
+    fps = initial_fps > 0 ? initial_fps : 30.0;
+
+    // 1 t[̃oCg
+    const size_t size(static_cast<size_t>(pixelformat == V4L2_PIX_FMT_YUYV ? 2 * width * height
+      : pixelformat == V4L2_PIX_FMT_NV12 ? width * height * 3 / 2 : width * height));
+
+    // t@Cʑ
+    const int file_fd(::open(file, O_RDONLY));
+    if (file_fd < 0) return false;
+    struct stat st;
+    const bool ok(fstat(file_fd, &st) == 0 && static_cast<size_t>(st.st_size) >= size);
+    void *const address(ok ? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, file_fd, 0) : MAP_FAILED);
+    ::close(file_fd);
+    if (address == MAP_FAILED) return false;
+    replayMemory = static_cast<const GLubyte *>(address);
+    replaySize = st.st_size;
+    replayCount = replaySize / size;
+    replayIndex = 0;
+    replayDue = std::chrono::steady_clock::now();
+
+    // foCX̃obt@̑Ƀt[̃mۂăL[ɓ
+    imageSize = size;
+    allocate(std::max(buffers, 4));
+    enqueueAll();
+
+    return true;
+  }
+
+  // Lv`foCX̉ftH[}bg𓾂
+  __u32 getFourcc() const
+  {
+    return fourcc;
+  }
+
+  // Lv`foCX̃t[[g𓾂
+  double getFps() const
+  {
+    return fps;
+  }
+};
@@ -8,25 +8,517 @@
 #include "gg.h"
 using namespace gg;
 
+// OpenGL ̃ReLXgɊւ鏈
+#include "Context.h"
+
+// wi摜̃eNX`
+#include "SourceTexture.h"
+
 // Lv`񓯊ōs
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+
+// WCu
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 //
 // J֘ȀSNX
 //
 class Camera
 {
+public:
+
+  // eNX`ւ̓]@
+  enum Transfer
+  {
+    CLIENT_MEMORY,    // NCAg̃璼ړ]
+    PIXEL_BUFFER,     // sNZobt@IuWFNg̃OɕʂĂ]
+    STAGING_BUFFER    // iIɃ}bvXe[WOobt@ɒڃLv`ē]
+  };
+
+  // Lv`t[L^NX̃C^tF[X
+  //   record() ̓Lv`XbhĂ΂B
+  class Recorder
+  {
+  public:
+
+    // fXgN^
+    virtual ~Recorder() {}
+
+    // t[L^
+    //   frame ̓t[̃Atime ̓t[Lv`
+    virtual void record(const GLubyte *frame, std::chrono::steady_clock::time_point time) = 0;
+  };
+
+private:
+
   // Rs[RXgN^𕕂
   Camera(const Camera &c);
 
   // 𕕂
   Camera &operator=(const Camera &w);
 
-protected:
+  // Lv`摜ێt[̃v[
+  //   Lv`Xbh backA`Xbh] frontA
+  //   ҂̊ԂŎ󂯓n middle ̎O̃t[g (Odobt@O)B
+  //   ȊÕt[͔hNXǂ݂ɎgB
+  std::vector<GLubyte *> frames;
+
+  // 1 t[̃oCg
+  GLsizeiptr frameSize;
+
+  // t[NCAg̃ɒuƂ̃
+  std::vector<GLubyte> frameMemory;
+
+  // t[uXe[WOobt@ (NCAg̃ɒuƂ 0)
+  GLuint stagingBuffer;
+
+  // Xe[WOobt@̃t[eNX`ւ̓]̊҂tFX
+  std::vector<GLsync> stagingFence;
+
+  // Lv`Xbhރt[̔ԍ
+  int back;
+
+  // `Xbh]t[̔ԍ
+  int front;
+
+  // 󂯓np̃t[̔ԍƐVt[Ă邱Ƃ
+  //   (ԍ << 1) |  ̌`Ŋi[ÃXbh atomic ɌB
+  std::atomic<unsigned int> middle;
+
+  // Lv`t[̐
+  std::atomic<unsigned long> captured;
+
+  // `Xbhɓ]Oɏ㏑ꂽt[̐
+  std::atomic<unsigned long> overwritten;
+
+  // fR[ht[̐ƃfR[hɗvԂ̍v
+  std::atomic<unsigned long> decoded;
+  std::atomic<std::chrono::steady_clock::rep> decodeTime;
+
+  // ꂼ̃t[Lv`ꂽ
+  std::vector<std::chrono::steady_clock::time_point> stamp;
+
+  // Lv``Xbh󂯎܂ł̎Ԃ̍vƍől
+  double latency, latencyMax;
+
+  // `Xbh󂯎t[̐
+  unsigned long acquired;
+
+  // eNX`ւ̓]@
+  Transfer transfer;
+
+  // eNX`ւ̓]ɎgsNZobt@IuWFNg̃O
+  std::vector<GLuint> pixelBuffer;
+
+  // sNZobt@IuWFNgiIɃ}bv (}bvłȂ nullptr)
+  std::vector<GLubyte *> pixelMemory;
+
+  // sNZobt@IuWFNgeNX`ւ̓]̊҂tFX
+  std::vector<GLsync> pixelFence;
+
+  // ɎgsNZobt@IuWFNg̔ԍ
+  size_t pixelIndex;
+
+  // `XbheNX`ɓ]t[̐
+  unsigned long transmitted;
+
+  // eNX`ւ̓]ɗvԂ̍v
+  double transmitTime;
+
+  // ]̃eNX`z̃C[ (Ȃ GL_TEXTURE_2D ɓ])
+  GLint layer;
+
+  // F̕ʂ]eNX`
+  GLuint chroma;
+
+  // Lv`t[L^郌R[_
+  Recorder *recorder;
+
+  // őTCY𒴂̂ŕ]̃eNX`
+  const SourceTexture *texture;
+
+  // eNX`ɓ]t[̐؂o͈͂̍̈ʒuƑ傫 (傫 0 Ȃ؂oȂ)
+  GLint cropX, cropY;
+  GLsizei cropWidth, cropHeight;
+
+  // eNX`ɓ]` (؂o͈͂̍ォ̈ʒuƑ傫)
+  struct Region
+  {
+    GLint x, y;
+    GLsizei width, height;
+  };
+
+  // eNX`ɓ]`
+  std::vector<Region> regions;
+
+  // ^Cɕē]Ƃ̃^C̈ӂ̉f (0 Ȃ^CɕȂ)
+  GLsizei tileSize;
+
+  // ^C̗񐔂ƍs
+  GLsizei tileColumns, tileRows;
+
+  // ]^C̈ (`悷ƂɎQƂ^C 0 ȊO)
+  std::vector<unsigned char> tileVisible;
+
+  // ꂼ̃^Cɓ]t[ (`Xbh󂯎̔ԍ)
+  std::vector<unsigned long> tileFrame;
+
+  // eNX`ɓ]oCg̍v
+  double transmitBytes;
+
+  // Vt[nƂɕ`Xbh̃Cxg҂Nǂ
+  bool wakeup;
+
+  // Oɓnt[Ɠẽt[nȂǂ
+  bool skipRepeated;
+
+  // Oɓnt[̕
+  std::vector<GLubyte> lastFrame;
+
+  // Oɓnt[ƓêœnȂt[̐
+  std::atomic<unsigned long> repeated;
+
+  // ꊇϊ̂߂Ɏɍ킹ɂׂẴt[ɓnA͂̍ŌŊ߂ɏI邩ǂ
+  bool batch;
+
+  // ꊇϊœ͂̍Ō̃t[nI
+  std::atomic<bool> ended;
+
+  // t[Oɕ`Xbhɓnt[Ɠeǂׂ
+  //   t[Ŝ𒼑Oɓnt[̕ƔׁAĂΕXVB
+  //   Xe[WOobt@͏ݐpɃ}bvĂ̂ŁAɒut[ɂ͎gȂB
+  //   ꎞ~Xg[foCXJԂt[̂悤ɑSê̂邽߂̂̂ŁA
+  //   ZT[̎G܂ރCủfƔ肳邱Ƃ͂܂ȂB
+  bool isRepeated(const GLubyte *frame)
+  {
+    const size_t size(static_cast<size_t>(frameSize));
+    if (size == 0) return false;
+
+    // ŏ̃t[傫ςƂ͕邾
+    if (lastFrame.size() != size)
+    {
+      lastFrame.assign(frame, frame + size);
+      return false;
+    }
+
+    // vȂȂƂ납낾𕡐
+    //   eȂxǂނōς݁AĂĂǂݏ̓t[ꖇōςށB
+    constexpr size_t chunk(65536);
+    for (size_t offset = 0; offset < size; offset += chunk)
+    {
+      const size_t length(std::min(chunk, size - offset));
+      if (std::memcmp(lastFrame.data() + offset, frame + offset, length) != 0)
+      {
+        std::copy(frame + offset, frame + size, lastFrame.begin() + offset);
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // 摜̃tH[}bg 1 f̃oCg߂
+  static GLsizei getDepth(GLenum format)
+  {
+    return format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_BGRA || format == GL_RGBA ? 4 : 3;
+  }
+
+  // t[̋`͈̔͂ buffer ̌̃t[Ɠʒuɕʂ
+  //   ^Cɕ؂oȂ΃t[Ŝ𕡎ʂB
+  void copyRegion(const GLubyte *frame, GLubyte *buffer, const Region &region) const
+  {
+    // t[ŜȂxɕʂ
+    if (cropWidth == 0 && region.width == width && region.height == height)
+    {
+      std::copy(frame, frame + frameSize, buffer);
+      return;
+    }
+
+    // 1 f̃oCg 1 s̃oCg
+    const GLsizei depth(getDepth(format));
+    const GLsizeiptr row(static_cast<GLsizeiptr>(rowLength > 0 ? rowLength : width) * depth);
+
+    // t[̋`̍̈ʒu
+    const GLint left(cropX + region.x), top(cropY + region.y);
+
+    // `͈̔͂̍s𕡎ʂ
+    for (GLint y = top; y < top + region.height; ++y)
+    {
+      const GLsizeiptr offset(y * row + left * depth);
+      std::copy(frame + offset, frame + offset + region.width * depth, buffer + offset);
+    }
+
+    // F̕ʂ͏c̍s (U, V) ̑g 1 s̃oCg͋PxƓɂȂ
+    if (chromaOffset > 0)
+    {
+      for (GLint y = top / 2; y < (top + region.height) / 2; ++y)
+      {
+        const GLsizeiptr offset(chromaOffset + y * row + left);
+        std::copy(frame + offset, frame + offset + region.width, buffer + offset);
+      }
+    }
+  }
+
+  // ݃oChĂeNX`ɉ摜̋`͈̔͂]
+  //   pixels ̓NCAg̃̃t[̃AhXA
+  //   GL_PIXEL_UNPACK_BUFFER ɃoChobt@IuWFNg̃t[̃ItZbg
+  void texSubImage(const GLvoid *pixels, const Region &region)
+  {
+    // ̃t[ 1 s̉fƃt[̋`̍̈ʒuw肷
+    const GLint row(rowLength > 0 ? rowLength : width);
+
+    // eNX`Ȃ炻ꂼ̈ꖇɓ]
+    if (texture && texture->isTiled())
+    {
+      texture->subImage(pixels, row, cropX + region.x, cropY + region.y,
+        region.x, region.y, region.width, region.height, chromaOffset);
+    }
+    else
+    {
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, row);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, cropX + region.x);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, cropY + region.y);
+
+      if (layer < 0)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, region.x, region.y, region.width, region.height, format, GL_UNSIGNED_BYTE, pixels);
+      else
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x, region.y, layer, region.width, region.height, 1, format, GL_UNSIGNED_BYTE, pixels);
+
+      // F̕ʂ
+      if (chromaOffset > 0 && chroma)
+      {
+        // F̕ʂ̐擪
+        const GLvoid *const uv(static_cast<const GLubyte *>(pixels) + chromaOffset);
+
+        // c̉𑜓x (U, V) ̑gƂăeNX`jbg 1 ̃eNX`ɓ]
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, row / 2);
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, (cropX + region.x) / 2);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, (cropY + region.y) / 2);
+        glActiveTexture(GL_TEXTURE1);
+        if (layer < 0)
+        {
+          glBindTexture(GL_TEXTURE_2D, chroma);
+          glTexSubImage2D(GL_TEXTURE_2D, 0, region.x / 2, region.y / 2, region.width / 2, region.height / 2, GL_RG, GL_UNSIGNED_BYTE, uv);
+        }
+        else
+        {
+          glBindTexture(GL_TEXTURE_2D_ARRAY, chroma);
+          glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x / 2, region.y / 2, layer, region.width / 2, region.height / 2, 1, GL_RG, GL_UNSIGNED_BYTE, uv);
+        }
+        glActiveTexture(GL_TEXTURE0);
+      }
+
+      // f̊i[@ɖ߂
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    }
+
+    // ]oCgώZ
+    const GLsizeiptr pixels_count(static_cast<GLsizeiptr>(region.width) * region.height);
+    transmitBytes += static_cast<double>(chromaOffset > 0 ? pixels_count + pixels_count / 2 : pixels_count * getDepth(format));
+  }
+
+  // eNX`ɓ]`߂
+  //   ^CɕƂ͕`Ɏg^Ĉ`Xbh󂯎t[
+  //   ܂]ĂȂ̂AsƂɗׂ荇^C܂Ƃ߂ē]B
+  void findRegions()
+  {
+    regions.clear();
+
+    // ^CɕȂΐ؂o͈͑Ŝ]
+    if (tileSize == 0)
+    {
+      const Region region = { 0, 0, getCropWidth(), getCropHeight() };
+      regions.push_back(region);
+      return;
+    }
+
+    for (GLsizei j = 0; j < tileRows; ++j)
+    {
+      for (GLsizei i = 0; i < tileColumns;)
+      {
+        // ]ȂĂ悢^C͔΂
+        const size_t k(j * tileColumns + i);
+        if (!tileVisible[k] || tileFrame[k] == acquired)
+        {
+          ++i;
+          continue;
+        }
+
+        // Eɑ]ׂ^C܂Ƃ߂
+        GLsizei n(i);
+        while (n < tileColumns && tileVisible[j * tileColumns + n] && tileFrame[j * tileColumns + n] != acquired)
+          tileFrame[j * tileColumns + n++] = acquired;
+
+        // ܂Ƃ߂^C̋` (E[Ɖ[͐؂o͈͂Ő؂)
+        const GLint x(i * tileSize), y(j * tileSize);
+        const Region region =
+        {
+          x, y,
+          std::min(n * tileSize, getCropWidth()) - x,
+          std::min((j + 1) * tileSize, getCropHeight()) - y
+        };
+        regions.push_back(region);
+        i = n;
+      }
+    }
+  }
+
+  // obt@IuWFNgiIɃ}bvł邩ǂׂ
+  static bool persistentMapping()
+  {
+    // OpenGL ̃ReLXgȂ΃}bvłȂ
+    if (!hasCurrentContext()) return false;
+
+    // OpenGL 4.4 ȍ~ ARB_buffer_storage gΉiIɃ}bvł
+    GLint major, minor;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > 4 || (major == 4 && minor >= 4) || hasExtension("GL_ARB_buffer_storage");
+  }
+
+  // Xe[WOobt@폜
+  void deleteStagingBuffer()
+  {
+    // ]҂̃tFX폜
+    for (auto &fence : stagingFence)
+    {
+      if (fence) glDeleteSync(fence);
+      fence = nullptr;
+    }
+
+    // A}bvč폜
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &stagingBuffer);
+    stagingBuffer = 0;
+  }
+
+  // Xe[WOobt@̃t[̓]Î҂
+  void waitStagingBuffer(int frame)
+  {
+    if (stagingFence[frame])
+    {
+      while (glClientWaitSync(stagingFence[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+      glDeleteSync(stagingFence[frame]);
+      stagingFence[frame] = nullptr;
+    }
+  }
+
+  // eNX`ւ̓]ɎgsNZobt@IuWFNg̃O쐬
+  void createPixelBuffer(size_t count = 3)
+  {
+    // 1 t[̃oCg
+    const GLsizeiptr size(frameSize);
+
+    // iIɃ}bvł邩ǂ
+    const bool persistent(persistentMapping());
+
+    // sNZobt@IuWFNg쐬
+    pixelBuffer.resize(count);
+    pixelMemory.assign(count, nullptr);
+    pixelFence.assign(count, nullptr);
+    glGenBuffers(static_cast<GLsizei>(count), pixelBuffer.data());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer[i]);
+
+      if (persistent)
+      {
+        // ݐpŉiIɃ}bv܂܂ɂ
+        const GLbitfield flags(GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        pixelMemory[i] = static_cast<GLubyte *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+      }
+      else
+      {
+        // iIɃ}bvłȂΓ]̂тɃ}bv
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+      }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pixelIndex = 0;
+  }
+
+  // sNZobt@IuWFNg̃O폜
+  void deletePixelBuffer()
+  {
+    for (size_t i = 0; i < pixelBuffer.size(); ++i)
+    {
+      // ]҂̃tFX폜
+      if (pixelFence[i]) glDeleteSync(pixelFence[i]);
+
+      // iIɃ}bv
+      if (pixelMemory[i])
+      {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer[i]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+      }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(static_cast<GLsizei>(pixelBuffer.size()), pixelBuffer.data());
+    pixelBuffer.clear();
+    pixelMemory.clear();
+    pixelFence.clear();
+  }
+
+  // t[̓]`sNZobt@IuWFNgoRŃeNX`ɓ]
+  //   CPU ̓O̎̃sNZobt@IuWFNgɃt[𕡎ʂ邾ŁA
+  //   eNX`ւ̓] GPU őÕt[̕`ƕsčsB
+  void transmitPixelBuffer(const GLubyte *frame)
+  {
+    // O܂ĂȂ΍쐬
+    if (pixelBuffer.empty()) createPixelBuffer();
+
+    // gsNZobt@IuWFNg
+    const size_t i(pixelIndex);
+    pixelIndex = (pixelIndex + 1) % pixelBuffer.size();
+
+    // ̃sNZobt@IuWFNg̑O̓]Î҂
+    if (pixelFence[i])
+    {
+      while (glClientWaitSync(pixelFence[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+      glDeleteSync(pixelFence[i]);
+      pixelFence[i] = nullptr;
+    }
+
+    // t[̓]`sNZobt@IuWFNgɕʂ
+    const GLsizeiptr size(frameSize);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer[i]);
+    if (pixelMemory[i])
+    {
+      // iIɃ}bvɒڏ
+      for (const auto &region : regions) copyRegion(frame, pixelMemory[i], region);
+    }
+    else
+    {
+      // ȑO̓ejă}bvA񂾂A}bv
+      void *const memory(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+      if (memory) for (const auto &region : regions) copyRegion(frame, static_cast<GLubyte *>(memory), region);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // sNZobt@IuWFNgeNX`ɓ]
+    for (const auto &region : regions) texSubImage(nullptr, region);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // ]̊҂tFXݒ肷
+    if (pixelMemory[i]) pixelFence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
 
-  // Lv`摜
-  GLubyte *buffer;
+protected:
 
   // Lv`摜̕ƍ
   GLsizei width, height;
@@ -34,6 +526,14 @@ protected:
   // Lv`摜̃tH[}bg
   GLenum format;
 
+  // Lv`摜 1 s̉f (0 Ȃ width Ɠ)
+  GLint rowLength;
+
+  // F̕ʂ̃t[̐擪̃oCgʒu (0 ȂF̕ʂ͂Ȃ)
+  //   NV12 ̂悤ɋPxƐFʂ̕ʂɂȂĂƂ́APx݃oChĂeNX`ɁA
+  //   F setChroma() Ŏw肵eNX`ɓ]B
+  GLsizeiptr chromaOffset;
+
   // Xbh
   std::thread thr;
 
@@ -41,19 +541,204 @@ protected:
   std::mutex mtx;
 
   // s
-  bool run;
+  std::atomic<bool> run;
+
+  // Lv`Xbh҂~[ebNXƏϐ
+  std::mutex waitMutex;
+  std::condition_variable waitCondition;
 
   // t[Lv`
   virtual void capture() {};
 
+  // Lv`摜̃t[̃mۂ
+  //   count ͊mۂt[̐ (Odobt@O̎O܂)
+  void allocate(int count = 3)
+  {
+    // t[̃v[pӂ
+    count = std::max(count, 3);
+    frames.assign(count, nullptr);
+    stagingFence.assign(count, nullptr);
+    stamp.assign(count, std::chrono::steady_clock::time_point());
+
+    // 1 f̃oCg
+    const GLsizei depth(getDepth(format));
+
+    // 1 s̉f
+    const GLsizeiptr row(rowLength > 0 ? rowLength : width);
+
+    // 1 t[̃oCg (F̕ʂ΂̌ɏc̐F̕ʂ)
+    frameSize = chromaOffset > 0 ? chromaOffset + row * (height / 2) : row * height * depth;
+
+    // Xe[WOobt@gƂ
+    if (transfer == STAGING_BUFFER)
+    {
+      // iIɃ}bvłȂ
+      if (persistentMapping())
+      {
+        // ׂẴt[uXe[WOobt@쐬ĉiIɃ}bv
+        const GLbitfield flags(GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        glGenBuffers(1, &stagingBuffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, frameSize * count, nullptr, flags);
+        GLubyte *const memory(static_cast<GLubyte *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize * count, flags)));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        // }bvł
+        if (memory)
+        {
+          // ꂼ̃t[Xe[WOobt@ɔzu
+          for (int i = 0; i < count; ++i) frames[i] = memory + frameSize * i;
+          return;
+        }
+
+        // }bvłȂXe[WOobt@폜
+        glDeleteBuffers(1, &stagingBuffer);
+        stagingBuffer = 0;
+      }
+
+      // Xe[WOobt@gȂ΃sNZobt@IuWFNg̃Og
+      transfer = PIXEL_BUFFER;
+    }
+
+    // NCAg̃ɂׂẴt[̃mۂ
+    frameMemory.resize(frameSize * count);
+    for (int i = 0; i < count; ++i) frames[i] = frameMemory.data() + frameSize * i;
+  }
+
+  // Lv`foCXpӂt[̃v[ɂ
+  //   memory ͂ꂼ̃t[̃ (Oȏ)Asize  1 t[̃oCgB
+  //   foCX̃ GPU 猩Ȃ̂ŃXe[WOobt@͎gȂB
+  void attach(const std::vector<GLubyte *> &memory, GLsizeiptr size)
+  {
+    frames = memory;
+    frameSize = size;
+    stagingFence.assign(frames.size(), nullptr);
+    stamp.assign(frames.size(), std::chrono::steady_clock::time_point());
+    if (transfer == STAGING_BUFFER) transfer = PIXEL_BUFFER;
+  }
+
+  // Lv`Xbhރt[̃𓾂
+  //   Xe[WOobt@gƂ GPU 猩郁ɒڏނƂɂȂB
+  GLubyte *getBackBuffer()
+  {
+    return frames[back];
+  }
+
+  // 1 t[̃fR[hɗvԂL^
+  //   start ̓fR[hJn
+  void countDecode(std::chrono::steady_clock::time_point start)
+  {
+    decodeTime += (std::chrono::steady_clock::now() - start).count();
+    ++decoded;
+  }
+
+  // t[̃v[̃t[̐𓾂
+  int getFrameCount() const
+  {
+    return static_cast<int>(frames.size());
+  }
+
+  // t[̃v[ frame Ԗڂ̃t[̃𓾂
+  GLubyte *getFrame(int frame)
+  {
+    return frames[frame];
+  }
+
+  // Lv`Xbhރt[̔ԍ𓾂
+  int getBack() const
+  {
+    return back;
+  }
+
+  // t[̃v[ frame Ԗڂ̃t[`Xbhɓn
+  //   time ̓t[Lv` ([r[t@CȂ\ׂ)
+  //   󂯓np̃t[ƌAɕԂꂽt[̔ԍԂB
+  int exchange(int frame, std::chrono::steady_clock::time_point time)
+  {
+    // t[Lv`L^
+    stamp[frame] = time;
+
+    // R[_΃t[L^
+    if (recorder) recorder->record(frames[frame], time);
+
+    // Oɓnt[ƓeȂnɁÃt[ɂ̂܂܎܂
+    //   t[Xe[WOobt@ɒuĂƂ͓ǂݏoȂ̂ŒׂȂB
+    if (skipRepeated && !stagingBuffer && isRepeated(frames[frame]))
+    {
+      ++repeated;
+      return frame;
+    }
+
+    // 񂾃t[󂯓np̃t[ƌ
+    const unsigned int previous(middle.exchange(frame << 1 | 1, std::memory_order_acq_rel));
+
+    // t[`Xbhɓ]ĂȂΏ㏑ƂɂȂ
+    if (previous & 1) ++overwritten;
+
+    // Lv`t[𐔂
+    ++captured;
+
+    // Cxg҂Ă`XbhN
+    if (wakeup) postWakeup();
+
+    return previous >> 1;
+  }
+
+  // Lv`Xbh񂾃t[`Xbhɓn
+  //   time ̓t[Lv` ([r[t@CȂ\ׂ)
+  void publish(std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now())
+  {
+    // ͌t[ɏ
+    back = exchange(back, time);
+  }
+
+  // w肵ɂȂ邩A`XbhÕt[󂯎܂ŃLv`Xbh҂
+  //   due ̓t[nAacknowledge  true ȂÕt[󂯎܂ő҂B
+  //   Xbh̒~vꂽ false ԂB
+  bool wait(std::chrono::steady_clock::time_point due, bool acknowledge)
+  {
+    std::unique_lock<std::mutex> lock(waitMutex);
+
+    // ꊇϊł͎҂ɁAÕt[󂯎ꂽ炷Ɏn
+    if (batch)
+    {
+      due = std::chrono::steady_clock::now();
+      acknowledge = true;
+    }
+
+    // w肵ɂȂ܂ő҂ (Xbh̒~vꂽ璼ɖ߂)
+    waitCondition.wait_until(lock, due, [this]() { return !run; });
+
+    // Õt[󂯎܂ő҂
+    if (acknowledge)
+      waitCondition.wait(lock, [this]() { return !run || !(middle.load(std::memory_order_acquire) & 1); });
+
+    return run;
+  }
+
+  // ͂̍ŌɒBƂɌĂ
+  //   ꊇϊȂÏ true Ԃ̂ŁALv`Xbh͊߂ɏIB
+  bool finish()
+  {
+    if (!batch) return false;
+    ended = true;
+    if (wakeup) postWakeup();
+    return true;
+  }
+
 public:
 
   // RXgN^
   Camera()
+    : frameSize(0), stagingBuffer(0)
+    , back(0), front(1), middle(2 << 1), captured(0), overwritten(0), decoded(0), decodeTime(0)
+    , latency(0.0), latencyMax(0.0), acquired(0)
+    , transfer(CLIENT_MEMORY), pixelIndex(0), transmitted(0), transmitTime(0.0), layer(-1), chroma(0), recorder(nullptr), texture(nullptr)
+    , cropX(0), cropY(0), cropWidth(0), cropHeight(0)
+    , tileSize(0), tileColumns(0), tileRows(0), transmitBytes(0.0), wakeup(false), skipRepeated(false), repeated(0)
+    , batch(false), ended(false)
+    , rowLength(0), chromaOffset(0)
   {
-    // 摜܂擾ĂȂƂL^Ă
-    buffer = nullptr;
-
     // Xbh~Ԃł邱ƂL^Ă
     run = false;
   }
@@ -61,6 +746,12 @@ public:
   // fXgN^
   virtual ~Camera()
   {
+    // OpenGL ̃ReLXgcĂ΃obt@IuWFNg폜
+    if (hasCurrentContext())
+    {
+      if (!pixelBuffer.empty()) deletePixelBuffer();
+      if (stagingBuffer) deleteStagingBuffer();
+    }
   }
 
   // XbhN
@@ -79,14 +770,17 @@ public:
     // Lv`XbhsȂ
     if (run)
     {
-      // Lv`foCXbN
-      mtx.lock();
+      // ҋ@̃Lv`XbhƂ̋
+      waitMutex.lock();
 
       // Lv`Xbh̃[v~߂
       run = false;
 
       // bN
-      mtx.unlock();
+      waitMutex.unlock();
+
+      // ҋ@̃Lv`XbhN
+      waitCondition.notify_all();
 
       // 
       thr.join();
@@ -105,6 +799,127 @@ public:
     return height;
   }
 
+  // eNX`ɓ]t[͈̔͂؂o
+  //   x, y ͍̈ʒuAw, h ͑傫ŁAt[͂ݏo͏B
+  //   FLf̑g𕪂Ȃ悤ɈʒuƑ傫͋ɑB
+  //   JJĂXbhNOɎw肵AeNX`͐؂o傫ōB
+  void setCrop(GLint x, GLint y, GLsizei w, GLsizei h)
+  {
+    // t[̒Ɏ߂ċɑ
+    const GLint left(std::max(x, 0) & ~1), top(std::max(y, 0) & ~1);
+    const GLint right(std::min(x + w, width)), bottom(std::min(y + h, height));
+    cropX = left;
+    cropY = top;
+    cropWidth = std::min((right - left + 1) & ~1, (width - left) & ~1);
+    cropHeight = std::min((bottom - top + 1) & ~1, (height - top) & ~1);
+
+    // t[ŜɂȂȂ؂oȂ
+    if (cropWidth <= 0 || cropHeight <= 0 || (cropWidth == width && cropHeight == height))
+      cropX = cropY = cropWidth = cropHeight = 0;
+  }
+
+  // ჌ỸC[WT[NɊOڂ͈͂؂o
+  //   circle  fisheye.vert ɓnC[WT[N̔aƒSʒuŁA
+  //   C[WT[N̔a͉摜̍̔AS͉摜̒S circle.pq ꂽʒuɂȂB
+  void cropCircle(const GLfloat *circle)
+  {
+    const GLfloat cx((0.5f + circle[2]) * width), cy((0.5f + circle[3]) * height), r(0.5f * height);
+    const GLint left(static_cast<GLint>(std::floor(cx - r))), top(static_cast<GLint>(std::floor(cy - r)));
+    setCrop(left, top, static_cast<GLint>(std::ceil(cx + r)) - left, static_cast<GLint>(std::ceil(cy + r)) - top);
+  }
+
+  // ؂o͈͂̍̈ʒu𓾂
+  GLint getCropX() const
+  {
+    return cropX;
+  }
+  GLint getCropY() const
+  {
+    return cropY;
+  }
+
+  // eNX`ɓ]͈͂̕𓾂 (؂oȂΉ摜̕)
+  GLsizei getCropWidth() const
+  {
+    return cropWidth > 0 ? cropWidth : width;
+  }
+
+  // eNX`ɓ]͈͂̍𓾂 (؂oȂΉ摜̍)
+  GLsizei getCropHeight() const
+  {
+    return cropHeight > 0 ? cropHeight : height;
+  }
+
+  // 1 t[ɃeNX`ɓ]oCg𓾂
+  GLsizeiptr getUploadSize() const
+  {
+    const GLsizeiptr pixels(static_cast<GLsizeiptr>(getCropWidth()) * getCropHeight());
+    return chromaOffset > 0 ? pixels + pixels / 2 : pixels * getDepth(format);
+  }
+
+  // eNX`^Cɕĕ`Ɏg^C]
+  //   size ̓^C̈ӂ̉f (ɑ)A0 Ȃ^CɕȂB
+  //   ؂o͈͂w肵ƂɎw肷B
+  void setTileSize(GLsizei size)
+  {
+    tileSize = std::max(size, 0) & ~1;
+    tileColumns = tileSize > 0 ? (getCropWidth() + tileSize - 1) / tileSize : 0;
+    tileRows = tileSize > 0 ? (getCropHeight() + tileSize - 1) / tileSize : 0;
+
+    // ŏׂ͂Ẵ^C`ɎgA܂ǂ̃t[]ĂȂƂɂ
+    tileVisible.assign(tileColumns * tileRows, 1);
+    tileFrame.assign(tileColumns * tileRows, ~0UL);
+  }
+
+  // ^C̈ӂ̉f𓾂
+  GLsizei getTileSize() const
+  {
+    return tileSize;
+  }
+
+  // ^C̗񐔂𓾂
+  GLsizei getTileColumns() const
+  {
+    return tileColumns;
+  }
+
+  // ^C̍s𓾂
+  GLsizei getTileRows() const
+  {
+    return tileRows;
+  }
+
+  // `Ɏg^Cw肷
+  //   visible ͍ォsƂɕׂ^C̈ŁA`Ɏĝ 0 ȊOɂB
+  void setVisibleTiles(const std::vector<unsigned char> &visible)
+  {
+    if (visible.size() == tileVisible.size()) tileVisible = visible;
+  }
+
+  // 摜̃tH[}bg𓾂
+  GLenum getFormat() const
+  {
+    return format;
+  }
+
+  // 摜 1 s̉f𓾂 (0 Ȃ畝Ɠ)
+  GLint getRowLength() const
+  {
+    return rowLength;
+  }
+
+  // F̕ʂ̃t[̐擪̃oCgʒu𓾂 (0 ȂF̕ʂ͂Ȃ)
+  GLsizeiptr getChromaOffset() const
+  {
+    return chromaOffset;
+  }
+
+  // 1 t[̃oCg𓾂
+  GLsizeiptr getFrameSize() const
+  {
+    return frameSize;
+  }
+
   // Ovrvision Pro ̘Ioグ
   virtual void increaseExposure() {};
 
@@ -117,24 +932,247 @@ public:
   // Ovrvision Pro ̗
   virtual void decreaseGain() {};
 
-  // JbNĉ摜eNX`ɓ]
-  void transmit()
+  // Vt[ĂΓ]t[ɂ
+  bool acquire()
+  {
+    // Vt[ĂȂΉȂ
+    if (!(middle.load(std::memory_order_acquire) & 1)) return false;
+
+    // Xe[WOobt@gƂ̓Lv`Xbhɖ߂Oɂ̃t[̓]I点
+    if (stagingBuffer) waitStagingBuffer(front);
+
+    // ]ς񂾃t[󂯓np̃t[ƌ
+    front = middle.exchange(front << 1, std::memory_order_acq_rel) >> 1;
+
+    // t[Lv`Ă󂯎܂ł̎Ԃv
+    const double elapsed(std::chrono::duration<double>(std::chrono::steady_clock::now() - stamp[front]).count());
+    latency += elapsed;
+    if (elapsed > latencyMax) latencyMax = elapsed;
+    ++acquired;
+
+    // t[󂯎ƂLv`Xbhɒm点 (ǂ݃Xbhϐő҂̂őSN)
+    waitMutex.lock();
+    waitMutex.unlock();
+    waitCondition.notify_all();
+
+    // ]t[XV
+    return true;
+  }
+
+  // eNX`ւ̓]@w肷
+  //   STAGING_BUFFER ̓t[̃mۂO (Lv`foCXJO) 
+  //   OpenGL ̃ReLXg쐬Ăw肷BgȂ PIXEL_BUFFER ɂȂB
+  void setTransfer(Transfer method)
+  {
+    transfer = method;
+  }
+
+  // eNX`ւ̓]@𓾂
+  Transfer getTransfer() const
+  {
+    return transfer;
+  }
+
+  // Vt[nƂ postWakeup() ŕ`Xbh̃Cxg҂N
+  //   `Xbh Window::waitEvents() ŐVt[҂ƂɁAXbhNOɎw肷B
+  void setWakeup(bool wakeup)
+  {
+    this->wakeup = wakeup;
+  }
+
+  // Oɓnt[Ɠẽt[`XbhɓnȂ
+  //   XbhNOɎw肷Bt[ݐp̃Xe[WOobt@ɒu
+  //   STAGING_BUFFER ̓]ł͓eǂݏoȂ̂ŁAw肵ĂׂȂB
+  void setSkipRepeated(bool skip)
+  {
+    skipRepeated = skip;
+  }
+
+  // ꊇϊ̂߂ɂׂẴt[ɓn
+  //   t[̎҂ɕ`XbhÕt[󂯎玟n̂ŁA
+  //   t[㏑Ď邱Ƃ͂ȂB[r[t@CL^t@C
+  //   ŌŊ߂ɏIAisFinished()  true ɂȂBXbhNOɎw肷B
+  void setBatch(bool batch)
+  {
+    this->batch = batch;
+  }
+
+  // ꊇϊǂ
+  bool isBatch() const
+  {
+    return batch;
+  }
+
+  // ꊇϊœ͂̍Ō̃t[܂ŕ`Xbh󂯎ǂ
+  bool isFinished() const
+  {
+    return ended && !(middle.load(std::memory_order_acquire) & 1);
+  }
+
+  // Lv`t[L^郌R[_w肷
+  //   XbhNOɎw肷Bnullptr ȂL^ȂB
+  //   t[ݐp̃Xe[WOobt@ɒuĂƂ͓ǂݏoȂ̂ŁA
+  //   L^ false ԂBL^Ƃ͑̓]@gB
+  bool setRecorder(Recorder *recorder)
+  {
+    if (recorder && stagingBuffer) return false;
+    this->recorder = recorder;
+    return true;
+  }
+
+  // ]eNX`z̃C[ɂ
+  //   layer Ȃ GL_TEXTURE_2D ɓ]B
+  void setLayer(GLint layer)
+  {
+    this->layer = layer;
+  }
+
+  // F̕ʂ]eNX`w肷
+  //   F̕ʂƂ̓eNX`jbg 1 ɃoChē]B
+  void setChroma(GLuint texture)
+  {
+    chroma = texture;
+  }
+
+  // ]̃eNX`w肷
+  //   őTCY𒴂̂ŕeNX`ɂ͂ꎩg]A
+  //   łȂΌ݃eNX`jbg 0 ɃoChĂ̂ɓ]B
+  void setTexture(const SourceTexture *texture)
+  {
+    this->texture = texture;
+    chroma = texture ? texture->getChroma() : 0;
+  }
+
+  // F̕ʂ邩ǂ
+  bool hasChroma() const
+  {
+    return chromaOffset > 0;
+  }
+
+  // ]̃eNX`z̃C[𓾂
+  GLint getLayer() const
+  {
+    return layer;
+  }
+
+  // `Xbh󂯎t[Lv`ꂽ𓾂
+  std::chrono::steady_clock::time_point getStamp() const
+  {
+    return stamp[front];
+  }
+
+  // 󂯎t[̉摜eNX`ɓ]
+  //   ^CɕƂ͕`Ɏg^ĈA܂̃t[]ĂȂ̂]B
+  void transmitFrame()
   {
-    // J̃bN݂
-    if (mtx.try_lock())
+    // ]`߂
+    findRegions();
+    if (regions.empty()) return;
+
+    // ]Jn
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    switch (transfer)
     {
-      // Vf[^Ă
-      if (buffer)
-      {
-        // f[^eNX`ɓ]
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, buffer);
+    case STAGING_BUFFER:
+      // Xe[WOobt@̃t[ GPU ŃeNX`ɓ]
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+      for (const auto &region : regions) texSubImage(reinterpret_cast<const GLvoid *>(frameSize * front), region);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-        // f[^̓]L^
-        buffer = nullptr;
-      }
+      // ̃t[̓]̊҂tFXݒ肷
+      //   t[Vɕ`Ɏg^C]Ƃ́AO̓]Ɋ
+      //   VtFXΑ̂őÕtFX͍폜B
+      if (stagingFence[front]) glDeleteSync(stagingFence[front]);
+      stagingFence[front] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      break;
+
+    case PIXEL_BUFFER:
+      // sNZobt@IuWFNgoRŃeNX`ɓ]
+      transmitPixelBuffer(frames[front]);
+      break;
 
-      // J̃bN
-      mtx.unlock();
+    default:
+      // f[^𒼐ڃeNX`ɓ]
+      for (const auto &region : regions) texSubImage(frames[front], region);
+      break;
     }
+
+    // ]ɗvԂώZ
+    transmitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++transmitted;
+  }
+
+  // Vt[ĂΉ摜eNX`ɓ]
+  //   ^CɕƂ͐Vt[ĂȂĂA
+  //   Vɕ`Ɏg悤ɂȂ^Cɂ̃t[]B
+  //   Vt[󂯎 true ԂB
+  bool transmit()
+  {
+    // Vt[Ă]
+    const bool arrived(acquire());
+    if (arrived || tileSize > 0) transmitFrame();
+    return arrived;
+  }
+
+  // Lv`t[̐𓾂
+  unsigned long getCaptured() const
+  {
+    return captured;
+  }
+
+  // `Xbhɓ]Oɏ㏑ꂽt[̐𓾂
+  unsigned long getOverwritten() const
+  {
+    return overwritten;
+  }
+
+  // OƓêŕ`XbhɓnȂt[̐𓾂
+  unsigned long getRepeated() const
+  {
+    return repeated;
+  }
+
+  // fR[ht[̐𓾂
+  unsigned long getDecoded() const
+  {
+    return decoded;
+  }
+
+  // 1 t[̃fR[hɗvԂ̕ς𓾂
+  double getDecodeTime() const
+  {
+    const unsigned long count(decoded);
+    return count > 0 ? std::chrono::duration<double>(std::chrono::steady_clock::duration(decodeTime)).count() / count : 0.0;
+  }
+
+  // t[Lv`Ă`Xbh󂯎܂ł̎Ԃ̕ς𓾂
+  double getLatency() const
+  {
+    return acquired > 0 ? latency / acquired : 0.0;
+  }
+
+  // t[Lv`Ă`Xbh󂯎܂ł̎Ԃ̍ől𓾂
+  double getMaxLatency() const
+  {
+    return latencyMax;
+  }
+
+  // eNX`ɓ]t[̐𓾂
+  unsigned long getTransmitted() const
+  {
+    return transmitted;
+  }
+
+  // 1 t[̃eNX`ɓ]oCg̕ς𓾂
+  double getTransmitBytes() const
+  {
+    return acquired > 0 ? transmitBytes / acquired : 0.0;
+  }
+
+  // 1 t[̃eNX`ւ̓]ɗvԂ̕ς𓾂
+  double getTransmitTime() const
+  {
+    return transmitted > 0 ? transmitTime / transmitted : 0.0;
   }
 };
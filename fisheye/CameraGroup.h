@@ -0,0 +1,293 @@
+#pragma once
+
+//
+// ̃J̓Lv`
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// WCu
+#include <memory>
+#include <algorithm>
+#include <cmath>
+
+//
+// ̃J̃t[őăeNX`zɓ]NX
+//   ꂼ̃J󂯎t[́Ȃg낤܂œ]ɕێB
+//   łVt[xĂJ̃t[󂯎ĒǂB
+//
+class CameraGroup
+{
+  // Rs[RXgN^𕕂
+  CameraGroup(const CameraGroup &c);
+
+  // 𕕂
+  CameraGroup &operator=(const CameraGroup &w);
+
+  // O[vɑJ
+  std::vector<std::unique_ptr<Camera>> cameras;
+
+  // gƂ݂Ȃt[̎̍̋e͈
+  std::chrono::steady_clock::duration tolerance;
+
+  // ̂҂ē]񐔂̏
+  unsigned int holdLimit;
+
+  // ē]
+  unsigned int held;
+
+  // eNX`ɓ]ĂȂt[󂯎ĕێĂJ
+  std::vector<char> pending;
+
+  // ꂼ̃J̓]t[̎̑g̕ς̂̍vƐΒl̍ől
+  std::vector<double> drift, driftMax;
+
+  // ꂼ̃J̃t[e͈͂𒴂Ēxꂽ܂ܑg]
+  std::vector<unsigned long> mismatched;
+
+  // ꂼ̃JێĂt[]ɐVt[ɑւ
+  std::vector<unsigned long> dropped;
+
+  // ]t[̑g̐ƁÂĂ̂̐
+  unsigned long transmitted, matched;
+
+  // t[]eNX`zƐF̕ʂ]eNX`z
+  GLuint texture, chroma;
+
+  // eNX`z쐬
+  static GLuint createArray(GLuint texture, GLint internal, GLsizei width, GLsizei height, GLsizei layers, GLenum format)
+  {
+    if (!texture) glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internal, width, height, layers, 0, format, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+  }
+
+  // łVt[̎
+  std::chrono::steady_clock::time_point newest() const
+  {
+    std::chrono::steady_clock::time_point time(cameras[0]->getStamp());
+    for (auto &camera : cameras) time = std::max(time, camera->getStamp());
+    return time;
+  }
+
+public:
+
+  // RXgN^
+  //   tolerance ͓gƂ݂Ȃt[̎̍̋e͈ (b)A
+  //   hold ͎̂҂ē] transmit() ̌Ăяỏ񐔂̏
+  CameraGroup(double tolerance = 0.005, unsigned int hold = 3)
+    : tolerance(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(tolerance)))
+    , holdLimit(hold), held(0), transmitted(0), matched(0), texture(0), chroma(0)
+  {}
+
+  // fXgN^
+  virtual ~CameraGroup()
+  {
+    // ׂẴJ̃Xbh~
+    stop();
+
+    // eNX`z폜
+    if (hasCurrentContext())
+    {
+      if (texture) glDeleteTextures(1, &texture);
+      if (chroma) glDeleteTextures(1, &chroma);
+    }
+  }
+
+  // JJO[vɒǉ
+  //   J̓O[v폜BǉɃeNX`z̃C[ɂȂB
+  //   ǉJ̔ԍԂB
+  int add(Camera *camera)
+  {
+    const int index(static_cast<int>(cameras.size()));
+    camera->setLayer(index);
+    cameras.emplace_back(camera);
+    pending.push_back(0);
+    drift.push_back(0.0);
+    driftMax.push_back(0.0);
+    mismatched.push_back(0);
+    dropped.push_back(0);
+    return index;
+  }
+
+  // O[vɑJ̐𓾂
+  int size() const
+  {
+    return static_cast<int>(cameras.size());
+  }
+
+  // O[vɑJ𓾂
+  Camera &operator[](int index)
+  {
+    return *cameras[index];
+  }
+
+  // ׂẴJ̃Lv`Jn
+  void start()
+  {
+    for (auto &camera : cameras) camera->start();
+  }
+
+  // ׂẴJ̃Lv`~
+  void stop()
+  {
+    for (auto &camera : cameras) camera->stop();
+  }
+
+  // ׂẴJ̃t[߂eNX`z쐬
+  //   ׂẴJ̉摜̃TCYƃtH[}bgłȂ΂ȂȂB
+  //   tH[}bg SourceTexture Ɠf̃tH[}bgɍ킹A
+  //   NV12 ̂悤ɐF̕ʂΏc̉𑜓x GL_RG8 ̃eNX`zɂ]B
+  //   쐬łȂ false ԂB
+  bool createTexture()
+  {
+    if (cameras.empty()) return false;
+
+    // 擪̃J̉摜̃TCYƃtH[}bg
+    const GLsizei width(cameras[0]->getCropWidth()), height(cameras[0]->getCropHeight());
+    const GLenum format(cameras[0]->getFormat());
+    const bool hasChroma(cameras[0]->hasChroma());
+
+    // TCYƃtH[}bgقȂJ΍쐬Ȃ
+    for (auto &camera : cameras)
+      if (camera->getCropWidth() != width || camera->getCropHeight() != height
+        || camera->getFormat() != format || camera->hasChroma() != hasChroma) return false;
+
+    // J̐̃C[eNX`z쐬
+    texture = createArray(texture, SourceTexture::getInternalFormat(format), width, height, size(), format);
+    if (hasChroma) chroma = createArray(chroma, GL_RG8, width / 2, height / 2, size(), GL_RG);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // ꂼ̃J̐F̕ʂ͐F̃eNX`z̃C[ɓ]
+    for (auto &camera : cameras) camera->setChroma(chroma);
+
+    return true;
+  }
+
+  // eNX`z𓾂
+  GLuint getTexture() const
+  {
+    return texture;
+  }
+
+  // F̃eNX`z𓾂 (F̕ʂȂ 0)
+  GLuint getChroma() const
+  {
+    return chroma;
+  }
+
+  // ̑t[̑gĂ΃eNX`zɓ]
+  //   ܂]ĂȂt[ێĂJ́Ãt[g̍łV̂
+  //   e͈͂𒴂ĒxĂȂ΁Ag낤܂Ŏ̃t[󂯎炸ɕێB
+  //   t[̑g] true ԂB
+  bool transmit()
+  {
+    if (cameras.empty()) return false;
+
+    // ێĂt[̂łV̂̎
+    const std::chrono::steady_clock::time_point latest(newest());
+
+    // ێĂt[ȂAꂪxĂJVt[󂯎
+    bool arrived(false);
+    for (int i = 0; i < size(); ++i)
+    {
+      if (pending[i] && latest - cameras[i]->getStamp() <= tolerance) continue;
+      if (cameras[i]->acquire())
+      {
+        // xꂽt[͓]ɐVt[ɑւ
+        if (pending[i]) ++dropped[i];
+        pending[i] = 1;
+        arrived = true;
+      }
+    }
+
+    // Vt[ێĂt[ȂΉȂ
+    if (!arrived && std::find(pending.begin(), pending.end(), 1) == pending.end()) return false;
+
+    // 󂯎t[̂łV̂̎
+    const std::chrono::steady_clock::time_point time(newest());
+
+    // łVt[苖e͈͂𒴂ĒxĂJ
+    bool aligned(true);
+    for (int i = 0; i < size(); ++i)
+      if (time - cameras[i]->getStamp() > tolerance) aligned = false;
+
+    // xĂJ̃t[͂̂҂
+    //   ̉񐔂𒴂đ҂A~܂JĂĂȂ܂ܓ]B
+    if (!aligned && ++held <= holdLimit) return false;
+    held = 0;
+
+    // t[̑g̎̕
+    //   Vt[󂯎ĂȂJ͑Oɓ]t[\̂ŁA̎gB
+    double mean(0.0);
+    for (auto &camera : cameras)
+      mean += std::chrono::duration<double>(camera->getStamp() - time).count();
+    mean /= size();
+
+    // ꂼ̃J̃t[̎̕ς̂ƒxꂽ܂ܓ]񐔂L^
+    for (int i = 0; i < size(); ++i)
+    {
+      const double d(std::chrono::duration<double>(cameras[i]->getStamp() - time).count() - mean);
+      drift[i] += d;
+      if (fabs(d) > driftMax[i]) driftMax[i] = fabs(d);
+      if (time - cameras[i]->getStamp() > tolerance) ++mismatched[i];
+    }
+    ++transmitted;
+    if (aligned) ++matched;
+
+    // ێĂt[ꂼ̃C[ɓ]
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    for (int i = 0; i < size(); ++i)
+    {
+      if (pending[i])
+      {
+        cameras[i]->transmitFrame();
+        pending[i] = 0;
+      }
+    }
+
+    return true;
+  }
+
+  // ]t[̑g̐𓾂
+  unsigned long getTransmitted() const
+  {
+    return transmitted;
+  }
+
+  // ]t[̑ĝĂ̂̐𓾂
+  unsigned long getMatched() const
+  {
+    return matched;
+  }
+
+  // index Ԗڂ̃J̃t[e͈͂𒴂Ēxꂽ܂ܑg]񐔂𓾂
+  unsigned long getMismatched(int index) const
+  {
+    return mismatched[index];
+  }
+
+  // index Ԗڂ̃JێĂt[]ɐVt[ɑւ𓾂
+  unsigned long getDropped(int index) const
+  {
+    return dropped[index];
+  }
+
+  // index Ԗڂ̃J̓]t[̎̑g̕ς̂̕ς𓾂 (b, Ȃił)
+  double getDrift(int index) const
+  {
+    return transmitted > 0 ? drift[index] / transmitted : 0.0;
+  }
+
+  // index Ԗڂ̃J̓]t[̎̑g̕ς̂̐Βl̍ől𓾂 (b)
+  double getMaxDrift(int index) const
+  {
+    return driftMax[index];
+  }
+};
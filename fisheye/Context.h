@@ -0,0 +1,85 @@
+#pragma once
+
+//
+// OpenGL ̃ReLXgɊւ鏈 (EBhEJƂJȂƂg)
+//
+
+// ⏕vO
+#include "gg.h"
+
+// EBhEJ EGL ŃReLXg
+#if defined(HEADLESS)
+#  include <EGL/egl.h>
+#  include <EGL/eglext.h>
+#  include <mutex>
+#  include <condition_variable>
+#  include <chrono>
+#endif
+
+// WCu
+#include <cstring>
+
+// ݂̃Xbh OpenGL ̃ReLXg邩ǂ
+//   EBhEjɃobt@IuWFNgȂǂ폜Ȃ悤ɂ邽߂ɎgB
+inline bool hasCurrentContext()
+{
+#if defined(HEADLESS)
+  return eglGetCurrentContext() != EGL_NO_CONTEXT;
+#else
+  return glfwGetCurrentContext() != nullptr;
+#endif
+}
+
+// ݂̃ReLXg OpenGL ̊g@\g邩ǂ
+inline bool hasExtension(const char *name)
+{
+  GLint count(0);
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i)
+  {
+    const GLubyte *const extension(glGetStringi(GL_EXTENSIONS, i));
+    if (extension && strcmp(reinterpret_cast<const char *>(extension), name) == 0) return true;
+  }
+  return false;
+}
+
+#if defined(HEADLESS)
+// `XbhNƁA҂~[ebNXƏϐ
+//   EBhEȂ glfwPostEmptyEvent() ͎gȂ̂őɎgB
+struct Wakeup
+{
+  std::mutex mtx;
+  std::condition_variable cond;
+  bool posted;
+};
+
+// `XbhN𓾂
+inline Wakeup &getWakeup()
+{
+  static Wakeup wakeup{};
+  return wakeup;
+}
+
+// `XbhN邩 timeout bo߂܂ő҂
+inline void waitWakeup(double timeout)
+{
+  Wakeup &wakeup(getWakeup());
+  std::unique_lock<std::mutex> lock(wakeup.mtx);
+  wakeup.cond.wait_for(lock, std::chrono::duration<double>(timeout), [&wakeup]() { return wakeup.posted; });
+  wakeup.posted = false;
+}
+#endif
+
+// Cxg҂Ă`Xbh𑼂̃XbhN
+inline void postWakeup()
+{
+#if defined(HEADLESS)
+  Wakeup &wakeup(getWakeup());
+  wakeup.mtx.lock();
+  wakeup.posted = true;
+  wakeup.mtx.unlock();
+  wakeup.cond.notify_all();
+#else
+  glfwPostEmptyEvent();
+#endif
+}
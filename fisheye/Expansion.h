@@ -0,0 +1,88 @@
+#pragma once
+
+//
+// WJɎgVF[_ɋʂ̃p[^̃jtH[obt@
+//
+
+// ⏕vO
+#include "gg.h"
+using namespace gg;
+
+// WCu
+#include <algorithm>
+
+// WJɎgVF[_ Expansion ubNƓ std140 ̃CAEg̃p[^
+//   fixed.vert, rectangle.vert, fisheye.vert, theta.vert, panorama.vert ׂēubN錾B
+struct Expansion
+{
+  GLfloat rotation[16];         // XN[]ϊs (VF[_ł row_major Ŏ󂯎)
+  GLfloat screen[4];            // XN[̑傫ƒSʒu
+  GLfloat circle[4];            // wieNX`̔aƒSʒu
+  GLfloat crop[4];              // wieNX`ɐ؂ot[͈̔
+  GLfloat gap[2];               // XN[̊iqԊu
+  GLfloat focal;                // XN[܂ł̏œ_
+  GLint adaptive;               // KIɕbVgǂ
+  GLint views;                  // xɕ`r[̐ (0 Ȃ̃r[Sʂɕ`)
+  GLint instances;              // ̃r[`CX^X̐
+  GLint projection;             // WJ̓e (0: e, 1: ~}@)
+  GLint padding;                // ubN̑傫 vec4 ̔{ɂ
+};
+
+// Expansion ubÑp[^i[郆jtH[obt@
+//   p[^͒l߂ƂŏłA`̒O send() ňxɓ]B
+//   WJɎgVF[_؂ւĂ uniform ϐ̏ꏊ𒲂גKvȂB
+class ExpansionBuffer
+{
+  // WJɎgVF[_ɓnp[^
+  Expansion parameter;
+
+  // p[^i[郆jtH[obt@
+  GgUniformBuffer<Expansion> buffer;
+
+  // |Cg (MultiView.h  Views ubN 0 g)
+  const GLuint binding;
+
+  // Rs[RXgN^𕕂
+  ExpansionBuffer(const ExpansionBuffer &c);
+
+  // 𕕂
+  ExpansionBuffer &operator=(const ExpansionBuffer &w);
+
+public:
+
+  // RXgN^
+  ExpansionBuffer(GLuint binding = 1)
+    : parameter(), buffer(&parameter, 1, GL_DYNAMIC_DRAW), binding(binding)
+  {
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.getBuffer());
+  }
+
+  // fXgN^
+  virtual ~ExpansionBuffer()
+  {}
+
+  // p[^QƂ
+  Expansion *operator->()
+  {
+    return &parameter;
+  }
+
+  // sxNg̃p[^ݒ肷
+  static void set(GLfloat *dst, const GLfloat *src, int count)
+  {
+    std::copy(src, src + count, dst);
+  }
+
+  // p[^jtH[obt@ɓ]
+  void send() const
+  {
+    buffer.send(&parameter, 1);
+  }
+
+  // WJɎgVF[_ Expansion ubÑjtH[obt@̌|CgɌт
+  void bind(GLuint program) const
+  {
+    const GLuint index(glGetUniformBlockIndex(program, "Expansion"));
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+  }
+};
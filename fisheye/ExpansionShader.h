@@ -4,6 +4,14 @@
 // ʓWJɎgVF[_
 //
 
+// Lv`摜̉f̌`
+enum CaptureColor
+{
+  CAPTURE_BGR,    // BGR (OpenCV ϊ)
+  CAPTURE_YUYV,   // YUYV (4:2:2) VF[_ RGB ɕϊ
+  CAPTURE_NV12    // NV12 (4:2:0) VF[_ RGB ɕϊ
+};
+
 // VF[_̃Zbgƃp[^
 struct ExpansionShader
 {
@@ -18,35 +26,44 @@ struct ExpansionShader
 
   // C[WT[N̔aƒSʒu
   const float circle[4];
+
+  // Lv`摜̉f̌`
+  const CaptureColor color;
 };
 
+// WJɎgtOgVF[_̑OɒuwieNX`̃TvÕ\[XvÕt@C
+constexpr char expansion_common[] = "background.glsl";
+
 // VF[_̎
 constexpr ExpansionShader shader_type[] =
 {
   // 0: ʏ̃J
-  { "fixed.vert",     "normal.frag",    640,  480, 1.0f, 1.0f, 0.0f, 0.0f },
+  { "fixed.vert",     "normal.frag",    640,  480, 1.0f, 1.0f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 1: ʏ̃JŎ_]
-  { "rectangle.vert", "normal.frag",    640,  480, 1.0f, 1.0f, 0.0f, 0.0f },
+  { "rectangle.vert", "normal.frag",    640,  480, 1.0f, 1.0f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 2: ~}@̉摜 (cɂ GL_CLAMP_TO_BORDER  GL_REPEAT ɂĂ)
-  { "panorama.vert",  "panorama.frag", 1280,  720, 1.0f, 1.0f, 0.0f, 0.0f },
+  { "panorama.vert",  "panorama.frag", 1280,  720, 1.0f, 1.0f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 3: 180J : 3.1415927 / 2 ( 180/ 2)
-  { "fisheye.vert",   "normal.frag",   1280,  720, 1.570796327f, 1.570796327f, 0.0f, 0.0f },
+  { "fisheye.vert",   "normal.frag",   1280,  720, 1.570796327f, 1.570796327f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 4: 180J (FUJINON FE185C046HA-1 + SENTECH STC-MCE132U3V) : 3.5779249 / 2 ( 205/ 2)
-  { "fisheye.vert",   "normal.frag",   1280, 1024, 1.797689129f, 1.797689129f, 0.0f, 0.0f },
+  { "fisheye.vert",   "normal.frag",   1280, 1024, 1.797689129f, 1.797689129f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 5: 206J (Kodak PIXPRO SP360 4K, U␳) : 3.5953783 / 2 ( 206/ 2)
-  { "fisheye.vert",   "normal.frag",   1440, 1440, 1.797689129f, 1.797689129f, 0.0f, 0.0f },
+  { "fisheye.vert",   "normal.frag",   1440, 1440, 1.797689129f, 1.797689129f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 6: 235J (Kodak PIXPRO SP360 4K, U␳Ȃ) : 4.1015237 / 2 ( 235/ 2)
-  { "fisheye.vert",   "normal.frag",   1440, 1440, 2.050761871f, 2.050761871f, 0.0f, 0.0f },
+  { "fisheye.vert",   "normal.frag",   1440, 1440, 2.050761871f, 2.050761871f, 0.0f, 0.0f, CAPTURE_BGR },
 
   // 7: RICHO THETA  USB CuXg[~Of : (蓮Ō߂l)
-  { "theta.vert",     "theta.frag",    1280,  720, 1.003f, 1.003f, 0.0f, -0.002f },
+  { "theta.vert",     "theta.frag",    1280,  720, 1.003f, 1.003f, 0.0f, -0.002f, CAPTURE_BGR },
 
   // 8: RICHO THETA  HDMI CuXg[~Of : (蓮Ō߂l)
-  { "theta.vert",     "theta.frag",    1920,  1080, 1.003f, 1.003f, 0.0f, -0.002f }
+  { "theta.vert",     "theta.frag",    1920,  1080, 1.003f, 1.003f, 0.0f, -0.002f, CAPTURE_BGR },
+
+  // 9: RICHO THETA  HDMI CuXg[~Of YUYV ̂܂ܓ (Video4Linux2 g)
+  { "theta.vert",     "theta.frag",    1920,  1080, 1.003f, 1.003f, 0.0f, -0.002f, CAPTURE_YUYV }
 };
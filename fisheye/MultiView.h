@@ -0,0 +1,229 @@
+#pragma once
+
+//
+// ̃J؂ỏzIȃpE`gEY[̃r[
+//
+
+// ɉeNX`̃^C̑I (ẽf)
+#include "ViewTiles.h"
+
+// WCu
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// EBhEiqɋ؂āA̔wieNX`炻ꂼʂ̌ƃY[̃r[`NX
+//   r[Ƃ̎̉]AXN[A``Aœ_jtH[obt@Ɋi[ĂA
+//   WJɎgVF[_̓CX^X̔ԍr[IԂ̂ŁAׂẴr[
+//   glDrawArraysInstanced() ŕ`BbV̊iq_̓r[̐ŕ̂ŁA
+//   _̐̓r[̐ɂ炸EBhEŜłقڈɂȂB
+//   ̘̂Zʂp 90 ̘Z̃r[Ƃē@ňxɕ`B
+class MultiView
+{
+public:
+
+  // WJ̓e
+  enum Projection
+  {
+    PERSPECTIVE,        // ̕𓧎e
+    CUBEMAP,            // ̘̂Zʂ 3~2 ɕׂ
+    EQUIRECTANGULAR     // S𐳋~}@ŕ` (r[͈)
+  };
+
+  // xɕ`r[̍ő吔 (WJɎgVF[_ Views ubN̔z̑傫)
+  static constexpr int maxViews = 16;
+
+  // jtH[obt@Ɋi[r[̃p[^ (std140 ̃CAEg)
+  struct View
+  {
+    GLfloat rotation[16];       // ̉]s (VF[_ł row_major Ŏ󂯎)
+    GLfloat screen[4];          // XN[̑傫ƒSʒu
+    GLfloat tile[4];            // NbsOԏ̃r[̋`̑傫ƒSʒu
+    GLfloat focal;              // XN[܂ł̏œ_
+    GLfloat padding[3];         // \̂̑傫 vec4 ̔{ɂ
+  };
+
+  // jtH[obt@̓e
+  struct Block
+  {
+    View view[maxViews];
+  };
+
+private:
+
+  // WJɎgVF[_̓ẽf
+  ViewTiles::Model model;
+
+  // r[̐Ɣzu̗񐔂ƍs
+  const int count, columns, rows;
+
+  // ׂẴr[ɋʂ̃`g
+  const GLfloat elevation;
+
+  // r[Ƃ̑Ŝ̎ɑ΂ƃY[ (œ_̔{)
+  std::vector<GgMatrix> orientation;
+  std::vector<GLfloat> zoom;
+
+  // ̘̂Zʂ`ǂ
+  bool cubemap;
+
+  // jtH[obt@ɓ]r[̃p[^
+  Block block;
+
+  // r[̃p[^i[郆jtH[obt@
+  GgUniformBuffer<Block> buffer;
+
+  // ViewTiles ɓnr[Ƃ̎̉]sAXN[Aœ_
+  std::vector<GLfloat> rotations, screens, focals;
+
+  // Rs[RXgN^𕕂
+  MultiView(const MultiView &c);
+
+  // 𕕂
+  MultiView &operator=(const MultiView &w);
+
+public:
+
+  // RXgN^
+  //   vsrc ͓WJɎgo[ebNXVF[_̃\[Xt@CAcount ̓r[̐A
+  //   elevation ׂ͂Ẵr[ɋʂ̃`g (WA)B
+  //   r[̃p͑SɓԊuɊ蓖āAォEցAォ牺ׂ֕B
+  MultiView(const char *vsrc, int count, GLfloat elevation = 0.0f)
+    : model(ViewTiles::getModel(vsrc))
+    , count(count < 1 ? 1 : count > maxViews ? maxViews : count)
+    , columns(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(this->count)))))
+    , rows((this->count + columns - 1) / columns)
+    , elevation(elevation), orientation(this->count), zoom(this->count, 1.0f), cubemap(false)
+    , block(), buffer(&block, 1, GL_DYNAMIC_DRAW)
+    , rotations(this->count * 16), screens(this->count * 4), focals(this->count)
+  {
+    arrange();
+  }
+
+  // fXgN^
+  virtual ~MultiView()
+  {}
+
+  // r[̃pSɓԊuɊ蓖Ă
+  void arrange()
+  {
+    for (int i = 0; i < count; ++i) setView(i, 6.2831853f * i / count, elevation, 1.0f);
+  }
+
+  // WJɎgVF[_؂ւƂɓẽfύX
+  //   p鎲ς̂ŁÂ̘ZʂłȂ΃r[̌ƃY[̕тɖ߂B
+  void setModel(const char *vsrc)
+  {
+    model = ViewTiles::getModel(vsrc);
+    if (!cubemap) arrange();
+  }
+
+  // r[̃pA`g (WA) ƃY[ݒ肷
+  //   ჌Y₻̉摜ʂł͌ (z ) SɁAS̉摜ł͉ (y ) SɃpB
+  void setView(int i, GLfloat pan, GLfloat tilt, GLfloat zoom)
+  {
+    const bool spherical(model == ViewTiles::EQUIRECTANGULAR || model == ViewTiles::DUAL_FISHEYE);
+    setView(i, (spherical ? ggRotateY(pan) : ggRotateZ(pan)) * ggRotateX(tilt), zoom);
+  }
+
+  // r[̑Ŝ̎ɑ΂̉]sƃY[ݒ肷
+  void setView(int i, const GgMatrix &orientation, GLfloat zoom)
+  {
+    if (i < 0 || i >= count) return;
+    this->orientation[i] = orientation;
+    this->zoom[i] = zoom;
+  }
+
+  // ̘̂Zʂ`
+  //   r[Z̂Ƃ FFmpeg  v360 tB^ c3x2 ƓA̒iɉEAAA
+  //   ̒iɉAOA̖ʂׂBO -z ŁAp 90 ɌŒ肵ăY[ȂB
+  bool setCubemap()
+  {
+    if (count != 6) return false;
+    const GLfloat half(1.5707963f);
+    setView(0, ggRotateY(-half), 1.0f);
+    setView(1, ggRotateY(half), 1.0f);
+    setView(2, ggRotateX(half), 1.0f);
+    setView(3, ggRotateX(-half), 1.0f);
+    setView(4, ggIdentity(), 1.0f);
+    setView(5, ggRotateY(half * 2.0f), 1.0f);
+    cubemap = true;
+    return true;
+  }
+
+  // r[̐𓾂
+  int getCount() const
+  {
+    return count;
+  }
+
+  // r[|[g̃AXyNg䂩̃r[̋`̃AXyNg߂
+  GLfloat getAspect(GLfloat aspect) const
+  {
+    return aspect * rows / columns;
+  }
+
+  // Ŝ̎̉]Əœ_Ar[|[g̃AXyNg䂩r[Ƃ̃p[^߂ē]
+  //   rotation  focal ͈̃r[`ƂɓWJɎgVF[_ɓn̂ƓB
+  void update(const GgMatrix &rotation, GLfloat focal, GLfloat aspect)
+  {
+    // ̃r[̋`̃AXyNg (̖̂ʂ͋`̌`ɂ炸`̃XN[ɂ)
+    const GLfloat tileAspect(cubemap ? 1.0f : getAspect(aspect));
+
+    for (int i = 0; i < count; ++i)
+    {
+      View &view(block.view[i]);
+
+      // r[̌
+      //   VF[_͍s]uĎĝŁAŜ̉]̉Er[̌̉]
+      //   ɁA̓]u炩B
+      const GgMatrix m(orientation[i].transpose() * rotation);
+      std::copy(m.get(), m.get() + 16, view.rotation);
+
+      // XN[̃TCYƒSʒu̓r[̋`̃AXyNgɍ킹
+      const GLfloat screen[] = { tileAspect, 1.0f, 0.0f, 0.0f };
+      std::copy(screen, screen + 4, view.screen);
+
+      // r[̋`̑傫ƒSʒu
+      const int column(i % columns), row(i / columns);
+      view.tile[0] = 1.0f / columns;
+      view.tile[1] = 1.0f / rows;
+      view.tile[2] = static_cast<GLfloat>(2 * column + 1) / columns - 1.0f;
+      view.tile[3] = 1.0f - static_cast<GLfloat>(2 * row + 1) / rows;
+
+      // Y[͏œ_ɂ (̖̂ʂ͏œ_ 1 ŉp 90 ɂ)
+      view.focal = cubemap ? 1.0f : focal * zoom[i];
+
+      // QƂ^C߂ƂɎg
+      std::copy(view.rotation, view.rotation + 16, rotations.begin() + i * 16);
+      std::copy(view.screen, view.screen + 4, screens.begin() + i * 4);
+      focals[i] = view.focal;
+    }
+
+    // ׂẴr[̃p[^xɓ]
+    buffer.send(&block, 1);
+  }
+
+  // jtH[obt@WJɎgVF[_ Views ubNɌ
+  void bind(GLuint program, GLuint binding = 0) const
+  {
+    const GLuint index(glGetUniformBlockIndex(program, "Views"));
+    if (index == GL_INVALID_INDEX) return;
+    glUniformBlockBinding(program, index, binding);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.getBuffer());
+  }
+
+  // r[Ƃ̎̉]s (sD)AXN[Aœ_𓾂
+  const GLfloat *getRotations() const
+  {
+    return rotations.data();
+  }
+  const GLfloat *getScreens() const
+  {
+    return screens.data();
+  }
+  const GLfloat *getFocals() const
+  {
+    return focals.data();
+  }
+};
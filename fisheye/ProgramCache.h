@@ -0,0 +1,396 @@
+#pragma once
+
+//
+// VF[_vÕoCĩLbV
+//
+
+// OpenGL ̃ReLXgɊւ鏈
+#include "Context.h"
+using namespace gg;
+
+// WCu
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// NvOIuWFNg̃oCit@CɕۑāA̋N̓RpCɓǂݍރNX
+//   LbṼt@C̓VF[_̃\[Xt@C̑gƂɈŁA\[XvO̓e (#define ܂)
+//    OpenGL ̎ (x_A_AhCõo[W) 狁߂nbVl擪ɋL^ĂB
+//   nbVlႤoCi󂯕tȂ΁ARpCăt@CB
+//   tOgVF[_̑Oɋʂ̃\[Xt@C (background.glsl Ȃ) uăRpCłB
+//   begin() ̓N̊҂Ȃ̂ŁARpC̊g@\΂̃vO
+//   ɃRpCāApoll() ŏÎgBق̃Xbh̋LReLXgłgB
+class ProgramCache
+{
+  // LbṼt@C̐擪ɒu
+  struct Header
+  {
+    char magic[4];              // t@C̎ʎq "FEPB"
+    std::uint32_t format;       // glGetProgramBinary() ԂoCǐ`
+    std::uint64_t key;          // \[XvO OpenGL ̎̃nbVl
+    std::uint32_t length;       // oCi̒
+    std::uint32_t padding;      // \̂̑傫 8 ̔{ɂ
+  };
+
+  // N̊҂ĂvOIuWFNg
+  struct Pending
+  {
+    GLuint program;             // vOIuWFNg
+    GLuint shader[2];           // o[ebNXVF[_ƃtOgVF[_̃VF[_IuWFNg
+    const char *source[2];      // ꂼ̃\[Xt@C
+    std::string name;           // LbṼt@C
+    std::uint64_t key;          // \[XvO OpenGL ̎̃nbVl
+    bool cached;                // LbVɕۑ邩ǂ
+  };
+
+  // LbṼt@C̑Oɕt镶 (fBNg܂߂Ă悢)
+  static std::string &prefix()
+  {
+    static std::string prefix;
+    return prefix;
+  }
+
+  // N̊₢킹邩ǂ
+  static bool &parallel()
+  {
+    static bool parallel(false);
+    return parallel;
+  }
+
+  // N̊҂ĂvOIuWFNg̈ꗗ
+  static std::vector<Pending> &pending()
+  {
+    static std::vector<Pending> pending;
+    return pending;
+  }
+
+  // ꗗƏWvق̃XbhƔrIɍXV~[ebNX
+  static std::mutex &mutex()
+  {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  // LbVǂݍ񂾐ƃRpC
+  static unsigned int &count(int i)
+  {
+    static unsigned int count[2] = { 0, 0 };
+    return count[i];
+  }
+
+  // vOIuWFNg̍쐬ɗvԂ̍v
+  static double &elapsed()
+  {
+    static double elapsed(0.0);
+    return elapsed;
+  }
+
+  // FNV-1a ŕnbVlɉ
+  static std::uint64_t hash(std::uint64_t key, const std::string &text)
+  {
+    for (unsigned char c : text) key = (key ^ c) * 0x100000001b3ull;
+
+    // ؂ 0 āAׂ̕Ƃ̋ڂႤ̂ʂ
+    return key * 0x100000001b3ull;
+  }
+
+  // OpenGL ̕𓾂
+  static std::string getString(GLenum name)
+  {
+    const GLubyte *const string(glGetString(name));
+    return string ? reinterpret_cast<const char *>(string) : "";
+  }
+
+  // VF[_̃\[Xt@Cǂݍ
+  static bool readSource(const char *name, std::string &source)
+  {
+    std::ifstream file(name, std::ios::binary);
+    if (!file)
+    {
+      // t@CJȂ΃G[Ŗ߂
+      std::cerr << "Error: Can't open source file: " << name << std::endl;
+      return false;
+    }
+
+    source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+  }
+
+  // LbṼt@C̃oCivOIuWFNg
+  //   t@CȂAnbVlႤANɎs 0 ԂB
+  static GLuint restore(const std::string &name, std::uint64_t key)
+  {
+    std::ifstream file(name, std::ios::binary);
+    if (!file) return 0;
+
+    Header header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof header)
+      || std::string(header.magic, 4) != "FEPB" || header.key != key || header.length == 0) return 0;
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) return 0;
+
+    // hCoXVăoCi󂯕tȂ΃NɎs
+    const GLuint program(glCreateProgram());
+    glProgramBinary(program, header.format, binary.data(), header.length);
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+      glDeleteProgram(program);
+      return 0;
+    }
+
+    return program;
+  }
+
+  // vOIuWFNg̃oCiLbṼt@Cɕۑ
+  static void store(const std::string &name, std::uint64_t key, GLuint program)
+  {
+    GLint length;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    const Header header = { { 'F', 'E', 'P', 'B' }, format, key, static_cast<std::uint32_t>(length), 0 };
+    std::ofstream file(name, std::ios::binary);
+    if (!file) return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof header);
+    file.write(binary.data(), length);
+  }
+
+  // ԂώZď𐔂
+  static void account(std::chrono::steady_clock::time_point start, int i)
+  {
+    const double time(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    std::lock_guard<std::mutex> lock(mutex());
+    elapsed() += time;
+    if (i >= 0) ++count(i);
+  }
+
+  // VF[_IuWFNg쐬ăRpCJn
+  //   common łȂ source ̑OɒuĈ̃VF[_ƂăRpCB
+  static GLuint compile(GLenum type, const std::string &source, const std::string &common = std::string())
+  {
+    const GLuint shader(glCreateShader(type));
+    const GLchar *const text[] = { common.c_str(), source.c_str() };
+    if (common.empty())
+      glShaderSource(shader, 1, text + 1, nullptr);
+    else
+      glShaderSource(shader, 2, text, nullptr);
+    glCompileShader(shader);
+    return shader;
+  }
+
+  // NIvOIuWFNg̃RpCƃŇʂ𒲂ׂ
+  //   OΕ\AĂ΃oCiLbVɕۑB
+  static bool finish(const Pending &entry)
+  {
+    // VF[_IuWFNg̃RpČ
+    GLint compiled(GL_TRUE);
+    for (int i = 0; i < 2; ++i)
+    {
+      GLint status, length;
+      glGetShaderiv(entry.shader[i], GL_COMPILE_STATUS, &status);
+      if (status == GL_FALSE)
+      {
+        std::cerr << "Compile Error in " << entry.source[i] << std::endl;
+        compiled = GL_FALSE;
+      }
+      glGetShaderiv(entry.shader[i], GL_INFO_LOG_LENGTH, &length);
+      if (length > 1)
+      {
+        std::vector<GLchar> log(length);
+        glGetShaderInfoLog(entry.shader[i], length, nullptr, log.data());
+        std::cerr << log.data() << std::endl;
+      }
+      glDetachShader(entry.program, entry.shader[i]);
+      glDeleteShader(entry.shader[i]);
+    }
+
+    // vOIuWFNg̃Ň
+    GLint linked, length;
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &linked);
+    if (compiled == GL_TRUE && linked == GL_FALSE) std::cerr << "Link Error." << std::endl;
+    glGetProgramiv(entry.program, GL_INFO_LOG_LENGTH, &length);
+    if (compiled == GL_TRUE && length > 1)
+    {
+      std::vector<GLchar> log(length);
+      glGetProgramInfoLog(entry.program, length, nullptr, log.data());
+      std::cerr << log.data() << std::endl;
+    }
+    if (compiled == GL_FALSE || linked == GL_FALSE) return false;
+
+    // NvOIuWFNg̃oCiۑ
+    if (entry.cached) store(entry.name, entry.key, entry.program);
+    return true;
+  }
+
+public:
+
+  // LbṼt@C̑Oɕt镶w肷
+  //   nullptr ȂLbVg킸ɖRpCB
+  static void setPrefix(const char *prefix)
+  {
+    ProgramCache::prefix() = prefix ? prefix : "";
+  }
+
+  // RpC̊g@\΃N̊₢킹đ҂Ȃ悤ɂ
+  //   GL_ARB_parallel_shader_compile ȂhCog邾̃XbhŃRpCB
+  //   g true ԂB
+  static bool setParallel()
+  {
+    const bool arb(hasExtension("GL_ARB_parallel_shader_compile"));
+    if (arb) glMaxShaderCompilerThreadsARB(0xffffffff);
+    parallel() = arb || hasExtension("GL_KHR_parallel_shader_compile");
+    return parallel();
+  }
+
+  // VF[_̃\[Xt@CǂݍŃvOIuWFNg̍쐬Jn
+  //   common w肷΂̃\[Xt@C frag ̑OɒuătOgVF[_RpCB
+  //   LbVg΂ɎgvOIuWFNgԂBłȂ΃RpCƃN
+  //   JnvOIuWFNgԂ̂ŁApoll()  true Ԃ܂ŎgȂB
+  //   \[Xt@Cǂ߂Ȃ 0 ԂB
+  static GLuint begin(const char *vert, const char *frag, const char *common = nullptr)
+  {
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+    // VF[_̃\[Xt@Cǂݍ
+    std::string vsrc, fsrc, csrc;
+    if (!readSource(vert, vsrc) || !readSource(frag, fsrc) || (common && !readSource(common, csrc))) return 0;
+
+    // oCǐ`Ȃ΃LbV͎gȂ
+    GLint formats(0);
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    const bool cached(!prefix().empty() && formats > 0);
+
+    // \[XvO OpenGL ̎̃nbVl
+    std::uint64_t key(0xcbf29ce484222325ull);
+    key = hash(key, getString(GL_VENDOR));
+    key = hash(key, getString(GL_RENDERER));
+    key = hash(key, getString(GL_VERSION));
+    key = hash(key, getString(GL_SHADING_LANGUAGE_VERSION));
+    key = hash(key, vsrc);
+    key = hash(key, csrc);
+    key = hash(key, fsrc);
+
+    // LbṼt@C
+    const std::string name(prefix() + vert + "_" + frag + ".bin");
+
+    // LbṼoCig΂g
+    if (cached)
+    {
+      const GLuint program(restore(name, key));
+      if (program)
+      {
+        account(start, 0);
+        return program;
+      }
+    }
+
+    // RpCƃNJn (ʂ poll() Œׂ)
+    const Pending entry =
+    {
+      glCreateProgram(),
+      { compile(GL_VERTEX_SHADER, vsrc), compile(GL_FRAGMENT_SHADER, fsrc, csrc) },
+      { vert, frag }, name, key, cached
+    };
+    glAttachShader(entry.program, entry.shader[0]);
+    glAttachShader(entry.program, entry.shader[1]);
+
+    // LbVɕۑȂoCio悤ɃN
+    if (cached) glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(entry.program);
+    mutex().lock();
+    pending().push_back(entry);
+    mutex().unlock();
+    account(start, -1);
+
+    return entry.program;
+  }
+
+  // begin() ō쐬JnvOIuWFNg̃NIǂ𒲂ׂ
+  //   IĂΌʂ𒲂ׂ true ԂBsĂvOIuWFNg폜 program  0 ɂB
+  //   wait  true N̊₢킹Ȃ΁AI܂ő҂B
+  static bool poll(GLuint &program, bool wait = false)
+  {
+    // N̊҂ĂȂΎg
+    mutex().lock();
+    std::vector<Pending>::iterator entry(pending().begin());
+    while (entry != pending().end() && entry->program != program) ++entry;
+    const bool waiting(entry != pending().end());
+    const Pending current(waiting ? *entry : Pending());
+    mutex().unlock();
+    if (!waiting) return true;
+
+    // ҂ȂȂ烊NIĂ邩₢킹
+    if (!wait && parallel())
+    {
+      GLint completed;
+      glGetProgramiv(program, GL_COMPLETION_STATUS_ARB, &completed);
+      if (completed == GL_FALSE) return false;
+    }
+
+    // ʂ𒲂ׂĈꗗ菜
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    const bool linked(finish(current));
+    mutex().lock();
+    for (entry = pending().begin(); entry != pending().end(); ++entry)
+    {
+      if (entry->program == program)
+      {
+        pending().erase(entry);
+        break;
+      }
+    }
+    mutex().unlock();
+    account(start, linked ? 1 : -1);
+
+    // sĂgȂ
+    if (!linked)
+    {
+      glDeleteProgram(program);
+      program = 0;
+    }
+    return true;
+  }
+
+  // VF[_̃\[Xt@CǂݍŃvOIuWFNg쐬
+  //   ggLoadShader() Ɠ쐬łȂ 0 ԂBLbVg΃RpCȂB
+  static GLuint load(const char *vert, const char *frag, const char *common = nullptr)
+  {
+    GLuint program(begin(vert, frag, common));
+    poll(program, true);
+    return program;
+  }
+
+  // LbVǂݍ񂾃vOIuWFNg̐𓾂
+  static unsigned int getRestored()
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    return count(0);
+  }
+
+  // RpCvOIuWFNg̐𓾂
+  static unsigned int getCompiled()
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    return count(1);
+  }
+
+  // vOIuWFNg̍쐬ɗvԂ̍v𓾂
+  //   ɃRpĈ̓RpCJnČʂ𒲂ׂ܂ł̎ԂŁA҂Ԃ͊܂܂ȂB
+  static double getTime()
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    return elapsed();
+  }
+};
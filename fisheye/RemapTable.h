@@ -0,0 +1,365 @@
+#pragma once
+
+//
+// WJ̉fƂ̃eNX`WQƕ\ɋ߂ĕ`
+//
+
+// wi摜̃eNX`
+#include "SourceTexture.h"
+
+// ɉeNX`̃^C̑I (ẽf)
+#include "ViewTiles.h"
+
+// ̃Y̑ȂBeu̐ݒ
+#include "Rig.h"
+
+// VF[_vÕoCĩLbV
+#include "ProgramCache.h"
+
+// ̃J̓Lv`
+#include "CameraGroup.h"
+
+// WCu
+#include <algorithm>
+#include <vector>
+
+// WJ̉fƂ̔wieNX`̃eNX`W𕂓_eNX`ɏĂłA
+// t[QƂ邾Ŕwi`NX
+//   ̉]œ_AC[WT[NAr[|[gςƂ蒼B
+//   eNX`W̓bV̒_ŋ߂ĕԂ̂ł͂ȂfƂɋ߂̂ŁA
+//   iq̊Ԃ̕Ԃɂ덷ȂB
+//   ̃Y̑ȂBeu (O) w肷΁AfƂɏd݂̑傫̃Y
+//   ̍Qƕ\ɋ߂ĂAt[̃eNX`̎QƂłȂŕ`B
+//   YƂɕʂ̃JŎBeƂ́AY̔ԍ̃eNX`z̃C[QƂB
+class RemapTable
+{
+  // WJɎgVF[_̓ẽf
+  ViewTiles::Model model;
+
+  // Qƕ\VF[_ƃO̎Qƕ\VF[_ƎQƕ\gĕ`VF[_
+  GLuint bake, rig, display;
+
+  // Qƕ\VF[_ uniform ϐ̏ꏊ
+  GLint modelLoc, screenLoc, focalLoc, rotationLoc, circleLoc, cropLoc, extentLoc;
+
+  // O̎Qƕ\VF[_ uniform ϐ̏ꏊ
+  GLint rigScreenLoc, rigFocalLoc, rigRotationLoc, lensesLoc, poseLoc, projectionLoc, fieldLoc;
+
+  // ÕY̐ݒ (Ȃ烊OgȂ)
+  std::vector<RigLens> lenses;
+
+  // Qƕ\gĕ`VF[_ uniform ϐ̏ꏊ
+  GLint lookupLoc, weightLoc, dualLoc, originLoc, yuvLoc, lensLoc, camerasLoc, cameraChromasLoc, groupLoc;
+
+  // Qƕ\t[obt@IuWFNg
+  GLuint framebuffer;
+
+  // Qƕ\̃eNX` (eNX`WƑÕeNX`̍ƃOŎg̃Y̔ԍ)
+  GLuint lookup, weight, lens;
+
+  // Qƕ\r[|[g
+  GLint viewport[4];
+
+  // Qƕ\Ƃ uniform ϐ̒l
+  std::vector<GLfloat> key;
+
+  // Qƕ\
+  unsigned long baked;
+
+  // _zIuWFNg
+  GLuint vao;
+
+  // Rs[RXgN^𕕂
+  RemapTable(const RemapTable &c);
+
+  // 𕕂
+  RemapTable &operator=(const RemapTable &w);
+
+  // g̃eNX`Wō邩ǂ
+  bool isDual() const
+  {
+    return model == ViewTiles::DUAL_FISHEYE || !lenses.empty();
+  }
+
+  // Qƕ\r[|[g̑傫ō蒼
+  void resize(const GLint *viewport)
+  {
+    std::copy(viewport, viewport + 4, this->viewport);
+
+    // theta.vert ƃO̓eNX`WgɂȂ
+    glBindTexture(GL_TEXTURE_2D, lookup);
+    glTexImage2D(GL_TEXTURE_2D, 0, isDual() ? GL_RGBA32F : GL_RG32F,
+      viewport[2], viewport[3], 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, weight);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, viewport[2], viewport[3], 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    if (!lenses.empty())
+    {
+      glBindTexture(GL_TEXTURE_2D, lens);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, viewport[2], viewport[3], 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, NULL);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // t[obt@IuWFNgɌ
+    //   Y̔ԍ̓ÔƂށB
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lookup, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weight, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, lenses.empty() ? 0 : lens, 0);
+    static const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(lenses.empty() ? 2 : 3, buffers);
+  }
+
+public:
+
+  // RXgN^
+  //   vsrc ͓WJɎgo[ebNXVF[_̃\[Xt@CB
+  RemapTable(const char *vsrc)
+    : model(ViewTiles::getModel(vsrc)), bake(0), rig(0), display(0), framebuffer(0), lookup(0), weight(0), lens(0)
+    , baked(0), vao(0)
+  {
+    // Qƕ\gĕ`VF[_ǂݍ
+    display = ProgramCache::load("quad.vert", "lookup.frag", "background.glsl");
+    if (!display) return;
+
+    // Qƕ\VF[_ǂݍ
+    //   ẽfȂΎgȂAWJɎgVF[_؂ւĂǂݍ܂ɍςނ悤ɂĂB
+    bake = ProgramCache::load("quad.vert", "remap.frag");
+    if (!bake) return;
+
+    modelLoc = glGetUniformLocation(bake, "model");
+    screenLoc = glGetUniformLocation(bake, "screen");
+    focalLoc = glGetUniformLocation(bake, "focal");
+    rotationLoc = glGetUniformLocation(bake, "rotation");
+    circleLoc = glGetUniformLocation(bake, "circle");
+    cropLoc = glGetUniformLocation(bake, "crop");
+    extentLoc = glGetUniformLocation(bake, "extent");
+
+    lookupLoc = glGetUniformLocation(display, "table");
+    weightLoc = glGetUniformLocation(display, "weight");
+    dualLoc = glGetUniformLocation(display, "dual");
+    originLoc = glGetUniformLocation(display, "origin");
+    yuvLoc = glGetUniformLocation(display, "yuv");
+    lensLoc = glGetUniformLocation(display, "lens");
+    camerasLoc = glGetUniformLocation(display, "cameras");
+    cameraChromasLoc = glGetUniformLocation(display, "cameraChromas");
+    groupLoc = glGetUniformLocation(display, "group");
+
+    // Qƕ\Ƃt[obt@IuWFNg
+    glGenTextures(1, &lookup);
+    glGenTextures(1, &weight);
+    glGenTextures(1, &lens);
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &vao);
+    std::fill(viewport, viewport + 4, 0);
+  }
+
+  // fXgN^
+  virtual ~RemapTable()
+  {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &lens);
+    glDeleteTextures(1, &weight);
+    glDeleteTextures(1, &lookup);
+    glDeleteProgram(display);
+    glDeleteProgram(rig);
+    glDeleteProgram(bake);
+  }
+
+  // Qƕ\g邩ǂ
+  //   OgȂΓẽfƂgB
+  bool isValid() const
+  {
+    return display && (lenses.empty() ? bake && model != ViewTiles::WHOLE : rig);
+  }
+
+  // WJɎgVF[_؂ւƂɓẽfύX
+  //   g̃eNX`Wgǂς邩Ȃ̂ŁA update() ŎQƕ\̌`蒼B
+  void setModel(const char *vsrc)
+  {
+    model = ViewTiles::getModel(vsrc);
+    std::fill(viewport, viewport + 4, 0);
+    key.clear();
+  }
+
+  // ̃Y̑ȂOw肷
+  //   ȂWJɎgVF[_̓ẽfɖ߂BY̐ݒ肪ςΎ update() ŎQƕ\蒼B
+  //   Y邩VF[_ǂݍ߂Ȃ false ԂB
+  bool setRig(const std::vector<RigLens> &lenses)
+  {
+    if (lenses.size() > static_cast<size_t>(rigMaxLenses)) return false;
+
+    // O̎Qƕ\VF[_͏߂ĎgƂɓǂݍ
+    if (!lenses.empty() && !rig)
+    {
+      rig = ProgramCache::load("quad.vert", "rig.frag");
+      if (!rig) return false;
+
+      rigScreenLoc = glGetUniformLocation(rig, "screen");
+      rigFocalLoc = glGetUniformLocation(rig, "focal");
+      rigRotationLoc = glGetUniformLocation(rig, "rotation");
+      lensesLoc = glGetUniformLocation(rig, "lenses");
+      poseLoc = glGetUniformLocation(rig, "pose");
+      projectionLoc = glGetUniformLocation(rig, "projection");
+      fieldLoc = glGetUniformLocation(rig, "field");
+    }
+
+    // g̃eNX`WgǂςƂ͎Qƕ\̌`蒼
+    if (lenses.empty() != this->lenses.empty()) std::fill(viewport, viewport + 4, 0);
+
+    this->lenses = lenses;
+    return true;
+  }
+
+  // ÕY̐𓾂
+  int getLenses() const
+  {
+    return static_cast<int>(lenses.size());
+  }
+
+  // WJ̃p[^OƈႦΎQƕ\蒼
+  //   screen, focal, rotation (sD), circle, crop ͓WJɎgVF[_ uniform ϐƓ́A
+  //   width, height ͔wieNX`Ŝ̑傫B蒼 true ԂB
+  bool update(const GLfloat *screen, GLfloat focal, const GLfloat *rotation, const GLfloat *circle,
+    const GLfloat *crop, GLsizei width, GLsizei height)
+  {
+    // ݂̃r[|[g
+    GLint current[4];
+    glGetIntegerv(GL_VIEWPORT, current);
+
+    // Qƕ\̓e߂l
+    std::vector<GLfloat> values(screen, screen + 4);
+    values.push_back(focal);
+    values.insert(values.end(), rotation, rotation + 16);
+    values.insert(values.end(), circle, circle + 4);
+    values.insert(values.end(), crop, crop + 4);
+    values.push_back(static_cast<GLfloat>(width));
+    values.push_back(static_cast<GLfloat>(height));
+    for (const RigLens &lens : lenses)
+    {
+      values.insert(values.end(), lens.pose, lens.pose + 9);
+      values.insert(values.end(), lens.projection, lens.projection + 4);
+      values.insert(values.end(), lens.field, lens.field + 2);
+    }
+
+    // r[|[gp[^ςĂȂ΍蒼Ȃ
+    const bool sized(std::equal(current + 2, current + 4, viewport + 2));
+    if (sized && values == key)
+    {
+      std::copy(current, current + 2, viewport);
+      return false;
+    }
+    key.swap(values);
+
+    // `̃t[obt@IuWFNgۑ
+    GLint target;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+    // r[|[g̑傫ςĂQƕ\蒼
+    if (sized)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+      std::copy(current, current + 2, viewport);
+    }
+    else
+      resize(current);
+
+    // fƂɃeNX`W߂ĎQƕ\Ɋi[
+    glViewport(0, 0, viewport[2], viewport[3]);
+    if (lenses.empty())
+    {
+      glUseProgram(bake);
+      glUniform1i(modelLoc, static_cast<GLint>(model));
+      glUniform4fv(screenLoc, 1, screen);
+      glUniform1f(focalLoc, focal);
+      glUniformMatrix4fv(rotationLoc, 1, GL_TRUE, rotation);
+      glUniform4fv(circleLoc, 1, circle);
+      glUniform4fv(cropLoc, 1, crop);
+      glUniform2i(extentLoc, width, height);
+    }
+    else
+    {
+      // Oł̓YƂɏd݂߂đ傫c
+      std::vector<GLfloat> pose, projection, field;
+      for (const RigLens &lens : lenses)
+      {
+        pose.insert(pose.end(), lens.pose, lens.pose + 9);
+        projection.insert(projection.end(), lens.projection, lens.projection + 4);
+        field.insert(field.end(), lens.field, lens.field + 2);
+      }
+      const GLsizei count(static_cast<GLsizei>(lenses.size()));
+      glUseProgram(rig);
+      glUniform4fv(rigScreenLoc, 1, screen);
+      glUniform1f(rigFocalLoc, focal);
+      glUniformMatrix4fv(rigRotationLoc, 1, GL_TRUE, rotation);
+      glUniform1i(lensesLoc, count);
+      glUniformMatrix3fv(poseLoc, count, GL_TRUE, pose.data());
+      glUniform4fv(projectionLoc, count, projection.data());
+      glUniform2fv(fieldLoc, count, field.data());
+    }
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // `ƃr[|[gɖ߂
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(current[0], current[1], current[2], current[3]);
+
+    ++baked;
+    return true;
+  }
+
+  // Qƕ\gĔwi`
+  //   texture ͔wieNX`Ayuv ͉f̌` (0: BGR, 1: YUYV, 2: NV12)B
+  //   group w肷΃ÕY̔ԍ̃J̃t[̃eNX`z񂩂QƂB
+  void draw(const SourceTexture &texture, GLint yuv, const CameraGroup *group = nullptr) const
+  {
+    glUseProgram(display);
+
+    // wieNX`
+    texture.bind();
+    texture.setUniforms(display);
+    glUniform1i(yuvLoc, yuv);
+
+    // Qƕ\̓eNX`jbg 4  5 Ɍ
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, lookup);
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, weight);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(lookupLoc, 4);
+    glUniform1i(weightLoc, 5);
+    glUniform1i(dualLoc, isDual());
+
+    // Y̔ԍ̓eNX`jbg 6 ɁAJ̃eNX`z 7  8 Ɍ
+    //   Tv̌^قȂ̂ŃJ̃O[vgȂƂʂ̃jbgw肵ĂB
+    const bool cameras(group && !lenses.empty());
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_2D, cameras ? lens : 0);
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cameras ? group->getTexture() : 0);
+    glActiveTexture(GL_TEXTURE8);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cameras ? group->getChroma() : 0);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(lensLoc, 6);
+    glUniform1i(camerasLoc, 7);
+    glUniform1i(cameraChromasLoc, 8);
+    glUniform1i(groupLoc, cameras);
+    glUniform2i(originLoc, viewport[0], viewport[1]);
+
+    // NbsOԑSʂ`
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  }
+
+  // Qƕ\񐔂𓾂
+  unsigned long getBaked() const
+  {
+    return baked;
+  }
+};
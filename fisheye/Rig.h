@@ -0,0 +1,101 @@
+#pragma once
+
+//
+// ̃Y̑̑S̉摜ɂȂBeu (O) ̐ݒ
+//
+
+// ⏕vO
+#include "gg.h"
+using namespace gg;
+
+// WCu
+#include <algorithm>
+#include <vector>
+
+// ̃t[ɎʂĂ鋛჌Y̑̌Ɣ͈ (ݒ̕\ɏl)
+//   yaw, pitch, roll ̓Y̌̌ (x)Bׂ 0 Ȃ -z ŁA
+//   y S yawAx S pitchAS roll ̏ɉ]B
+//   fov ͑gp (x)Afeather ͂Ȃڂŗׂ̃Yƍ镝 (x)A
+//   circle  fisheye.vert  circle ƓAt[̏c̔Ɏʂpx (WA) ƒSʒuB
+struct RigMount
+{
+  float yaw, pitch, roll;
+  float fov, feather;
+  float circle[4];
+};
+
+// Qƕ\VF[_ (rig.frag) ɓnY̐ݒ
+//   pose ͎Y̍WnɈڂ]s (sD)Aprojection ͌̊px
+//   eNX`W̕ωƌ̈ʒũeNX`WAfield ͑g̊px̏ƍ镝 (WA)B
+//   ܂ރŶȀ܂ł̊px̗]T傫gA]TƂȂڂɂB
+struct RigLens
+{
+  GLfloat pose[9];
+  GLfloat projection[4];
+  GLfloat field[2];
+};
+
+// xɂȂY̍ő吔 (rig.frag ̔z̑傫)
+constexpr int rigMaxLenses(8);
+
+// ˉe̋჌Y̌Ɣ͈͂烌Y̐ݒ
+//   width, height ̓t[̑傫B
+inline RigLens makeRigLens(const RigMount &mount, int width, int height)
+{
+  // Y̍Wn王̍Wnւ̉] Ry(yaw) Rx(pitch) Rz(roll) ̋tsDŊi[
+  //   GgMatrix ͗DȂ̂ŁẢ]s̔z̍ 3~3 sƂĎoΓ]uɂȂB
+  const GLfloat radian(0.01745329f);
+  const GgMatrix r(ggRotateY(mount.yaw * radian) * ggRotateX(mount.pitch * radian) * ggRotateZ(mount.roll * radian));
+  RigLens lens;
+  for (int k = 0; k < 3; ++k)
+    for (int l = 0; l < 3; ++l)
+      lens.pose[k * 3 + l] = r.get()[k * 4 + l];
+
+  // fisheye.vert ƓeNX`W̃XP[ƒS
+  lens.projection[0] = 0.5f * height / width / mount.circle[0];
+  lens.projection[1] = -0.5f / mount.circle[1];
+  lens.projection[2] = mount.circle[2] + 0.5f;
+  lens.projection[3] = mount.circle[3] + 0.5f;
+
+  // p̔̊px܂ł̑gAȂڂ̑O feather ̕ŗׂ̃Yƍ
+  lens.field[0] = mount.fov * 0.5f * radian;
+  lens.field[1] = std::max(mount.feather * radian, 1.0e-4f);
+  return lens;
+}
+
+// RICOH THETA ̑O̋჌Y̐ݒ theta.vert ƓvZō
+//   circle  theta.vert  circleAwidth, height ̓t[̑傫B
+//   Ȃڂō镝 theta.vert  smoothstep(-0.02, 0.02, angle) ɍ킹B
+inline std::vector<RigLens> makeDualFisheyeRig(const GLfloat *circle, int width, int height)
+{
+  // ƑÕY̑̃eNX`ԏ̔aƒS
+  const GLfloat rbx(circle[0] * -0.25f), rby(circle[1] * 0.25f * width / height);
+  const GLfloat cbx(rbx - circle[2] + 0.5f), cby(rby - circle[3]);
+
+  // ̊px /2 a 0.885 {ɂȂ
+  const GLfloat k(0.885f * 0.63661977f);
+
+  // theta.vert p̔̕
+  //   ͌炱̕𒴂ĎgAȂڂœ̃Y̗]T̍ 4 {͈̔͂ōΓɂȂB
+  const GLfloat margin(0.02f * 1.5707963f);
+
+  // ̃Y͌ +z ŁA 90 ]Ă
+  //   Y̍Wn (y, x, -z) ɂȂB
+  const RigLens back =
+  {
+    { 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f },
+    { rbx * k, rby * k, cbx, cby },
+    { 1.5707963f + margin * 2.0f, margin * 4.0f }
+  };
+
+  // ÕY͌ -z ŁA 90 ]čE]Ă
+  //   ]sɂ邽߂ x W̕𔽓] (y, -x, z) ƂAXP[̕Ŗ߂B
+  const RigLens front =
+  {
+    { 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { -rbx * k, -rby * k, cbx + 0.5f, cby },
+    { 1.5707963f + margin * 2.0f, margin * 4.0f }
+  };
+
+  return std::vector<RigLens>{ back, front };
+}
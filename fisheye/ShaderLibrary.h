@@ -0,0 +1,293 @@
+#pragma once
+
+//
+// sɐ؂ւWJɎgVF[_̃vÖꗗ
+//
+
+// EBhE֘Ȁ
+#include "Window.h"
+
+// ʓWJɎgVF[_
+#include "ExpansionShader.h"
+
+// VF[_vÕoCĩLbV
+#include "ProgramCache.h"
+
+// WCu
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// WJ̎@ (ExpansionShader.h  shader_type[] ̗vf) Ƃ̃vONɂׂčn߂ĂNX
+//   ŏɎg@̃vO͂ɍAc͕`~߂ɍBRpC̊g@\
+//   hCoɂ܂Ƃ߂ăRpCĖt[₢킹AȂΕ`Xbh̃ReLXg
+//   IuWFNgLReLXg̃XbhŏɃRpCB؂ւvꂽ@܂Ȃ
+//   ɃRpCB\[Xt@C̑g̎@͈̃vOLB
+//   ǂgȂ΁A߂ĎgƂɕ`XbhŃRpCB
+class ShaderLibrary
+{
+public:
+
+  // vO@
+  enum Method
+  {
+    SERIAL,             // ߂ĎgƂɕ`XbhŃRpC
+    PARALLEL,           // RpC̊g@\ŃhCoɂ܂Ƃ߂ăRpC
+    THREAD              // LReLXg̃XbhŏɃRpC
+  };
+
+private:
+
+  // vȌ
+  enum State
+  {
+    FAILED = -1,        // Ȃ
+    WAITING,            // ܂n߂ĂȂ
+    BUILDING,           // Ă
+    READY               // g
+  };
+
+  // WJ̎@Ƃ̃vO
+  struct Entry
+  {
+    const char *vsrc, *fsrc;    // o[ebNXVF[_ƃtOgVF[_̃\[Xt@C
+    int source;                 // \[Xt@C̑ggŏ̎@̔ԍ
+    GLuint program;             // vOIuWFNg
+    State state;                // vȌ
+  };
+
+  // LReLXgEBhE
+  Window &window;
+
+  // ŏɎg@̃vOL@̔ԍ
+  int first;
+
+  // WJ̎@Ƃ̃vO
+  std::vector<Entry> entry;
+
+  // vO@
+  Method method;
+
+  // LReLXgŃRpCXbh
+  std::thread thread;
+
+  // entry  requested  quit rIɑ삷~[ebNX
+  std::mutex mtx;
+
+  // ؂ւvꂽ@̔ԍ
+  int requested;
+
+  // XbhI
+  bool quit;
+
+  // Rs[RXgN^𕕂
+  ShaderLibrary(const ShaderLibrary &c);
+
+  // 𕕂
+  ShaderLibrary &operator=(const ShaderLibrary &w);
+
+  // \[Xt@C̑gg@ɃvOƏԂݒ肷
+  void set(int source, GLuint program, State state)
+  {
+    for (Entry &e : entry)
+    {
+      if (e.source == source)
+      {
+        e.program = program;
+        e.state = state;
+      }
+    }
+  }
+
+  // LReLXg̃XbhŁA؂ւvꂽ@ɁAcɃRpC
+  void compile()
+  {
+    window.makeSharedCurrent(true);
+
+    for (;;)
+    {
+      // ɃRpC@I
+      mtx.lock();
+      int next(-1);
+      if (!quit)
+      {
+        if (requested >= 0 && entry[requested].state == WAITING) next = entry[requested].source;
+        for (size_t i = 0; next < 0 && i < entry.size(); ++i)
+          if (entry[i].state == WAITING) next = entry[i].source;
+        if (next >= 0) set(next, 0, BUILDING);
+      }
+      mtx.unlock();
+      if (next < 0) break;
+
+      // `Xbh̃ReLXgŎgOɃNĂ
+      const GLuint program(ProgramCache::load(entry[next].vsrc, entry[next].fsrc, expansion_common));
+      glFinish();
+
+      mtx.lock();
+      set(next, program, program ? READY : FAILED);
+      mtx.unlock();
+
+      // Cxg҂Ă`XbhNĐ؂ւ
+      postWakeup();
+    }
+
+    window.makeSharedCurrent(false);
+  }
+
+public:
+
+  // RXgN^
+  //   window ͕`ɎgEBhEAtype  count ͓WJ̎@̕\Ƃ̗vfA
+  //   initial ͍ŏɎg@̔ԍŁAall  false Ȃ炻̃vOB
+  //   initial ̃vOȂ isValid()  false ɂȂB
+  ShaderLibrary(Window &window, const ExpansionShader *type, int count, int initial, bool all = true)
+    : window(window), first(-1), method(SERIAL), requested(-1), quit(false)
+  {
+    // \[Xt@C̑gg@܂Ƃ߂
+    for (int i = 0; i < count; ++i)
+    {
+      int source(i);
+      for (int j = 0; j < i; ++j)
+      {
+        if (strcmp(type[i].vsrc, type[j].vsrc) == 0 && strcmp(type[i].fsrc, type[j].fsrc) == 0)
+        {
+          source = j;
+          break;
+        }
+      }
+      entry.push_back(Entry{ type[i].vsrc, type[i].fsrc, source, 0, WAITING });
+    }
+
+    // ŏɎg@̃vO͂ɍ
+    if (initial < 0 || initial >= count) return;
+    first = entry[initial].source;
+    const GLuint program(ProgramCache::load(entry[first].vsrc, entry[first].fsrc, expansion_common));
+    set(first, program, program ? READY : FAILED);
+    if (!program || !all) return;
+
+    if (ProgramCache::setParallel())
+    {
+      // hCoɂ܂Ƃ߂ăRpC
+      method = PARALLEL;
+      for (int i = 0; i < count; ++i)
+      {
+        if (entry[i].source != i || entry[i].state != WAITING) continue;
+        const GLuint building(ProgramCache::begin(entry[i].vsrc, entry[i].fsrc, expansion_common));
+        set(i, building, building ? BUILDING : FAILED);
+      }
+    }
+    else if (window.createSharedContext())
+    {
+      // LReLXg̃XbhŏɃRpC
+      method = THREAD;
+      thread = std::thread(&ShaderLibrary::compile, this);
+    }
+  }
+
+  // fXgN^
+  virtual ~ShaderLibrary()
+  {
+    // RpCĂXbh~߂
+    if (thread.joinable())
+    {
+      mtx.lock();
+      quit = true;
+      mtx.unlock();
+      thread.join();
+    }
+
+    // vOIuWFNg폜
+    //   ₢킹ĂȂ̂Ňʂ𒲂ׂĈꗗ菜B
+    for (size_t i = 0; i < entry.size(); ++i)
+    {
+      if (entry[i].source != static_cast<int>(i) || entry[i].program == 0) continue;
+      if (entry[i].state == BUILDING) ProgramCache::poll(entry[i].program, true);
+      glDeleteProgram(entry[i].program);
+    }
+  }
+
+  // ŏɎg@̃vOꂽǂ
+  //   ̃vȌԂ̓XbhύXȂB
+  bool isValid() const
+  {
+    return first >= 0 && entry[first].state == READY;
+  }
+
+  // ɃRpCĂvÕNI₢킹
+  //   t[Ăׂ΁AgOɌʂ𒲂ׂăLbVɕۑĂB
+  void update()
+  {
+    if (method != PARALLEL) return;
+    for (size_t i = 0; i < entry.size(); ++i)
+    {
+      if (entry[i].source != static_cast<int>(i) || entry[i].state != BUILDING) continue;
+      GLuint program(entry[i].program);
+      if (ProgramCache::poll(program)) set(static_cast<int>(i), program, program ? READY : FAILED);
+    }
+  }
+
+  // WJ̎@ i ̃vO𓾂
+  //   ܂gȂ 0 ԂBLReLXg̃XbhŃRpCĂΎɂRpCA
+  //   ǂ̕@gȂ΂ŃRpCB
+  GLuint getProgram(int i)
+  {
+    if (i < 0 || i >= static_cast<int>(entry.size())) return 0;
+    const int source(entry[i].source);
+
+    switch (method)
+    {
+    case PARALLEL:
+      update();
+      break;
+
+    case THREAD:
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        requested = i;
+        return entry[source].state == READY ? entry[source].program : 0;
+      }
+
+    default:
+      if (entry[source].state == WAITING)
+      {
+        const GLuint program(ProgramCache::load(entry[source].vsrc, entry[source].fsrc, expansion_common));
+        set(source, program, program ? READY : FAILED);
+      }
+      break;
+    }
+
+    return entry[source].state == READY ? entry[source].program : 0;
+  }
+
+  // WJ̎@̐𓾂
+  int getCount() const
+  {
+    return static_cast<int>(entry.size());
+  }
+
+  // gvO̐𓾂
+  int getReady()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    int ready(0);
+    for (size_t i = 0; i < entry.size(); ++i)
+      if (entry[i].source == static_cast<int>(i) && entry[i].state == READY) ++ready;
+    return ready;
+  }
+
+  // ʂ̃vOɂ@̑g̐𓾂
+  int getPrograms() const
+  {
+    int programs(0);
+    for (size_t i = 0; i < entry.size(); ++i)
+      if (entry[i].source == static_cast<int>(i)) ++programs;
+    return programs;
+  }
+
+  // vO@𓾂
+  Method getMethod() const
+  {
+    return method;
+  }
+};
@@ -0,0 +1,335 @@
+#pragma once
+
+//
+// wi摜̃eNX`
+//
+
+// ⏕vO
+#include "gg.h"
+using namespace gg;
+
+// WCu
+#include <algorithm>
+#include <vector>
+
+// wi摜i[eNX`̃NX
+//   t[eNX`̍őTCYɎ܂ȂΈꖇɎ܂傫ɕA
+//   eNX`z̃C[Ɋi[Bꂼ̃C[ɂ͎͂ɗׂ̉f ([ł
+//   GL_REPEAT ƓΑ̉f)  1 fʂĂAڂł
+//   VF[_łЂƂȂ̃eNX`Ɠ悤ɑoꎟԂł悤ɂB
+//   PxƐF̕ʂɕ摜͐Fc̉𑜓x̕ʂ̃eNX`Ɋi[B
+class SourceTexture
+{
+  // Px܂͉f̐FƐF̃eNX`
+  GLuint image, chroma;
+
+  // eNX`Ŝ̑傫
+  GLsizei width, height;
+
+  // Ƃ̈ꖇɎ߂f (Ȃ 0)
+  GLsizei stride;
+
+  // Ƃ̗񐔂ƍs
+  GLsizei columns, rows;
+
+  // f̃tH[}bg
+  GLenum format;
+
+  // eNX`̊Oɂ邩ǂ
+  bool border;
+
+  // uniform ϐݒ肵VF[_vO
+  //   uniform ϐ̒l̓vOێ̂ŁAeNX`蒼܂Őݒ肵ȂB
+  mutable std::vector<GLuint> programs;
+
+  // Rs[RXgN^𕕂
+  SourceTexture(const SourceTexture &c);
+
+  // 𕕂
+  SourceTexture &operator=(const SourceTexture &w);
+
+  // eNX`̉f̈ʒu͈̔͂̈ꕔ
+  struct Segment
+  {
+    // C[̈ʒuƌ̃eNX`̈ʒuƒ
+    GLint local, global;
+    GLsizei length;
+  };
+
+  // ̃eNX`̈ʒu start  length f͈̔͂܂ԂĘA͈͂ɕ
+  //   start  -1 Astart + length  size + 1 ܂łŁAő 3 ͈̔͂ɕB
+  static int split(GLint start, GLsizei length, GLsizei size, Segment *segment)
+  {
+    int count(0);
+    GLint local(0);
+
+    // [ ([) ̊O͉E[ ([) ̉f
+    if (start < 0)
+    {
+      segment[count++] = { local, size + start, -start };
+      local -= start;
+      length += start;
+      start = 0;
+    }
+
+    // eNX`͈̔
+    const GLsizei inside(std::min(length, size - start));
+    segment[count++] = { local, start, inside };
+    local += inside;
+    length -= inside;
+
+    // E[ ([) ̊O͍[ ([) ̉f
+    if (length > 0) segment[count++] = { local, 0, length };
+
+    return count;
+  }
+
+  // eNX`̈̕ʂɋ`͈̔͂]
+  //   pixels ͂̕ʂ̐擪Arow  1 s̉fAleft  top ̓t[̋`̍̈ʒuA
+  //   x, y, w, h ̓eNX`̋`Ascale ͕ʂ̉𑜓x̋t (FȂ 2)B
+  void subImagePlane(GLuint texture, GLenum plane, const GLvoid *pixels, GLint row,
+    GLint left, GLint top, GLint x, GLint y, GLsizei w, GLsizei h, GLsizei scale) const
+  {
+    // ̕ʂ̑傫ƈꖇ̉f
+    const GLsizei size[] = { width / scale, height / scale };
+    const GLsizei step(stride / scale);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row);
+
+    for (GLsizei j = 0; j < rows; ++j)
+    {
+      // ̍si[c͈̔ (㉺ 1 f]Ɋ܂)
+      Segment sy[3];
+      const int ny(split(j * step - 1, std::min(step, size[1] - j * step) + 2, size[1], sy));
+
+      for (GLsizei i = 0; i < columns; ++i)
+      {
+        // ̗񂪊i[鉡͈̔ (E 1 f]Ɋ܂)
+        Segment sx[3];
+        const int nx(split(i * step - 1, std::min(step, size[0] - i * step) + 2, size[0], sx));
+
+        // ]`ƏdȂ镔̈ꖇɓ]
+        for (int v = 0; v < ny; ++v)
+        {
+          const GLint y0(std::max(sy[v].global, y)), y1(std::min(sy[v].global + sy[v].length, y + h));
+          if (y0 >= y1) continue;
+
+          for (int u = 0; u < nx; ++u)
+          {
+            const GLint x0(std::max(sx[u].global, x)), x1(std::min(sx[u].global + sx[u].length, x + w));
+            if (x0 >= x1) continue;
+
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, left + x0 - x);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, top + y0 - y);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, sx[u].local + x0 - sx[u].global, sy[v].local + y0 - sy[v].global,
+              j * columns + i, x1 - x0, y1 - y0, 1, plane, GL_UNSIGNED_BYTE, pixels);
+          }
+        }
+      }
+    }
+  }
+
+  // eNX`쐬
+  //   wrap ͕ȂeNX`̊ÖB
+  static GLuint createTexture(GLenum target, GLint internal, GLsizei width, GLsizei height, GLsizei layers, GLenum format,
+    GLenum wrap)
+  {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    if (target == GL_TEXTURE_2D_ARRAY)
+    {
+      // ڂ̉f͕ʂĂ̂ŃC[̊O͎QƂȂ
+      glTexImage3D(target, 0, internal, width, height, layers, 0, format, GL_UNSIGNED_BYTE, NULL);
+      glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    else
+    {
+      glTexImage2D(target, 0, internal, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+      glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap);
+      glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap);
+    }
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+    return texture;
+  }
+
+  // eNX`폜
+  void discard()
+  {
+    glDeleteTextures(1, &image);
+    if (chroma) glDeleteTextures(1, &chroma);
+    image = chroma = 0;
+    programs.clear();
+  }
+
+public:
+
+  // RXgN^
+  SourceTexture()
+    : image(0), chroma(0), width(0), height(0), stride(0), columns(0), rows(0), format(GL_BGR), border(false)
+  {}
+
+  // fXgN^
+  virtual ~SourceTexture()
+  {
+    discard();
+  }
+
+  // f̃tH[}bgeNX`̓tH[}bg߂
+  //   YUYV  (Y, U), (Y, V) ̑g GL_RG8 ɁANV12 ͋Px GL_R8 Ɋi[B
+  static GLint getInternalFormat(GLenum format)
+  {
+    return format == GL_RG ? GL_RG8 : format == GL_RED ? GL_R8 : GL_RGB;
+  }
+
+  // eNX`쐬
+  //   width, height ̓eNX`Ŝ̑傫Aformat ͉f̃tH[}bgA
+  //   hasChroma ͏c̉𑜓x (U, V) ̐F̃eNX`邩ǂB
+  //   limit ͈ꖇ̃eNX`̑傫̏ (0 ȂhCȍ)B
+  //   border  true ȂeNX`̊O܂Ԃɍɂ (C[WT[N؂ot[p)B
+  //   ĂeNX`z̃C[̏𒴂Ƃ false ԂB
+  bool create(GLsizei width, GLsizei height, GLenum format, bool hasChroma, GLsizei limit = 0, bool border = false)
+  {
+    discard();
+
+    // eNX`̍őTCYƃeNX`z̃C[̏
+    GLint maxSize, maxLayers;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (limit > 0) maxSize = std::min(maxSize, static_cast<GLint>(limit));
+
+    this->width = width;
+    this->height = height;
+    this->format = format;
+    this->border = border;
+
+    // OɂȂVF[_œĥŒ[̉f𔽑ΑƕԂȂ
+    const GLenum wrap(border ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+
+    // f̃tH[}bgɍ킹tH[}bg
+    const GLint internal(getInternalFormat(format));
+
+    // őTCYɎ܂΂̂܂܍쐬
+    if (width <= maxSize && height <= maxSize)
+    {
+      stride = columns = rows = 0;
+      image = createTexture(GL_TEXTURE_2D, internal, width, height, 1, format, wrap);
+      if (hasChroma) chroma = createTexture(GL_TEXTURE_2D, GL_RG8, width / 2, height / 2, 1, GL_RG, wrap);
+      return true;
+    }
+
+    // ͂ 1 fĈꖇɎ߂f (F𔼕ɂł悤ɋɂ)
+    stride = (maxSize - 2) & ~1;
+    columns = (width + stride - 1) / stride;
+    rows = (height + stride - 1) / stride;
+    if (columns * rows > maxLayers)
+    {
+      stride = columns = rows = 0;
+      return false;
+    }
+
+    // ꖇ̑傫
+    const GLsizei w(std::min(stride, width)), h(std::min(stride, height));
+
+    image = createTexture(GL_TEXTURE_2D_ARRAY, internal, w + 2, h + 2, columns * rows, format, wrap);
+    if (hasChroma) chroma = createTexture(GL_TEXTURE_2D_ARRAY, GL_RG8, w / 2 + 2, h / 2 + 2, columns * rows, GL_RG, wrap);
+    return true;
+  }
+
+  // Ă邩ǂ
+  bool isTiled() const
+  {
+    return stride > 0;
+  }
+
+  // Px܂͉f̐F̃eNX`𓾂
+  GLuint getImage() const
+  {
+    return image;
+  }
+
+  // F̃eNX`𓾂
+  GLuint getChroma() const
+  {
+    return chroma;
+  }
+
+  // eNX`Ŝ̉̉f𓾂
+  GLsizei getWidth() const
+  {
+    return width;
+  }
+
+  // eNX`Ŝ̏c̉f𓾂
+  GLsizei getHeight() const
+  {
+    return height;
+  }
+
+  // 𓾂 (Ȃ 1)
+  GLsizei getPieces() const
+  {
+    return isTiled() ? columns * rows : 1;
+  }
+
+  // eNX`eNX`jbgɃoCh
+  //   Ȃ 0 Ԃ 1 ԂɁA 2 Ԃ 3 Ԃ̃eNX`zɃoChB
+  void bind() const
+  {
+    const GLenum target(isTiled() ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+    const GLenum unit(isTiled() ? GL_TEXTURE2 : GL_TEXTURE0);
+    glActiveTexture(unit + 1);
+    glBindTexture(target, chroma);
+    glActiveTexture(unit);
+    glBindTexture(target, image);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+  // VF[_̃TvƃeNX`̕Ɋւ uniform ϐݒ肷
+  //   vOƂɃeNX`ĂŏɌĂяoƂݒ肷̂ŁA
+  //   vO؂ւ邽тɌĂяoĂ悢Bprogram gpĂȂĂ悢B
+  void setUniforms(GLuint program) const
+  {
+    // ̃vOɂ͐ݒς
+    if (std::find(programs.begin(), programs.end(), program) != programs.end()) return;
+    programs.push_back(program);
+
+    glProgramUniform1i(program, glGetUniformLocation(program, "image"), 0);
+    glProgramUniform1i(program, glGetUniformLocation(program, "chroma"), 1);
+    glProgramUniform1i(program, glGetUniformLocation(program, "images"), 2);
+    glProgramUniform1i(program, glGetUniformLocation(program, "chromas"), 3);
+    glProgramUniform2i(program, glGetUniformLocation(program, "extent"), width, height);
+    glProgramUniform3i(program, glGetUniformLocation(program, "pieces"), stride, columns, rows);
+    glProgramUniform1i(program, glGetUniformLocation(program, "border"), border);
+  }
+
+  // eNX`Ƀt[̋`͈̔͂]
+  //   pixels ̓t[̐擪 (GL_PIXEL_UNPACK_BUFFER ɃoChobt@IuWFNgȂItZbg)A
+  //   row ̓t[ 1 s̉fAleft  top ̓t[̋`̍̈ʒuA
+  //   x, y, w, h ̓eNX`̋`AchromaOffset ͐F̕ʂ̐擪 (Ȃ 0)B
+  void subImage(const GLvoid *pixels, GLint row, GLint left, GLint top,
+    GLint x, GLint y, GLsizei w, GLsizei h, GLsizeiptr chromaOffset) const
+  {
+    // Px܂͉f̐F̕ʂ]
+    glActiveTexture(GL_TEXTURE2);
+    subImagePlane(image, format, pixels, row, left, top, x, y, w, h, 1);
+
+    // F̕ʂc̉𑜓x (U, V) ̑gƂē]
+    if (chromaOffset > 0 && chroma)
+    {
+      glActiveTexture(GL_TEXTURE3);
+      subImagePlane(chroma, GL_RG, static_cast<const GLubyte *>(pixels) + chromaOffset, row / 2,
+        left / 2, top / 2, x / 2, y / 2, w / 2, h / 2, 2);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // f̊i[@ɖ߂
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  }
+};
@@ -0,0 +1,521 @@
+#pragma once
+
+//
+// ɉeNX`̃^C̑I
+//
+
+// J֘Ȁ
+#include "Camera.h"
+
+// WCu
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// ݂̎Ɖpŕ`ɎgeNX`̃^C߂NX
+//   wi摜̓WJɎgVF[_ƓvZŁAbV̊iqƂɎQƂ
+//   eNX`W͈̔͂ CPU ŋ߁AɏdȂ^CJɓ]B
+//   ̊pxƏœ_̕ω琔t[̎\āÃ^Cɓ]B
+class ViewTiles
+{
+public:
+
+  // WJɎgVF[_̓ẽf
+  enum Model
+  {
+    WHOLE,              // Ȃ̂ŏɂׂẴ^Cg
+    FIXED,              // ]Ȃ (fixed.vert)
+    RECTANGLE,          // ]ĉ摜ʂɓe (rectangle.vert)
+    FISHEYE,            // ˉe̋჌Y (fisheye.vert)
+    DUAL_FISHEYE,       // O̋჌Y (theta.vert)
+    EQUIRECTANGULAR     // ~}@ (panorama.vert)
+  };
+
+  // wieNX`̑傫ƌ̃t[̑傫Ɛ؂o͈͂̈ʒu
+  struct Extent
+  {
+    int textureWidth, textureHeight;
+    int frameWidth, frameHeight;
+    int cropX, cropY;
+  };
+
+  // xNgɑ΂eNX`W
+  //   tc[0]  blend < 1 ̂ƂAtc[1]  blend > 0 ̂ƂɎQƂB
+  struct Sample
+  {
+    double tc[2][2];
+    double blend;
+  };
+
+private:
+
+  // ẽf
+  Model model;
+
+  // oꎟԂŎQƂfɉė]Ɋ܂߂f
+  const int margin;
+
+  // \t[
+  const int ahead;
+
+  // _ƂɃeNX`W߂VF[_̃bV̊iqו鐔
+  int subdivision;
+
+  // O̎̉]sƏœ_
+  double previous[9];
+  double previousFocal;
+  bool hasPrevious;
+
+  // eNX`̑傫ƌ̃t[̑傫Ɛ؂o͈͂̈ʒu
+  Extent extent;
+
+  // ^C̈ӂ̉fƗ񐔂ƍs
+  int tileSize, columns, rows;
+
+  // `Ɏg^C̈
+  std::vector<unsigned char> visible;
+
+  // bV̊iq_ɂeNX`W
+  std::vector<Sample> samples;
+
+  // Rs[RXgN^𕕂
+  ViewTiles(const ViewTiles &c);
+
+  // 𕕂
+  ViewTiles &operator=(const ViewTiles &w);
+
+  // f̈ʒu͈̔ [p0, p1] ɏdȂ^C̔ԍ͈̔͂߂
+  //   eNX` GL_REPEAT Ȃ̂Ŕ͈͂܂ԂAɕꂽ 2 ԂB
+  int span(double p0, double p1, int size, int count, int *range) const
+  {
+    // eNX`Ŝɂ킽邩l܂Ȃ΂ׂẴ^C
+    if (!(p1 - p0 < size) || !(std::abs(p0) < 1.0e6))
+    {
+      range[0] = 0;
+      range[1] = count - 1;
+      return 1;
+    }
+
+    // ͈͂̎n_eNX`ɐ܂Ԃ
+    const double base(std::floor(p0 / size) * size);
+    const int a(std::min(std::max(static_cast<int>(p0 - base), 0), size - 1));
+    const int b(a + static_cast<int>(p1 - p0));
+
+    // eNX`̉E[ ([) zȂΈ͈̔
+    range[0] = a / tileSize;
+    if (b < size)
+    {
+      range[1] = b / tileSize;
+      return 1;
+    }
+
+    // z獶[ ([) ͈̔͂
+    range[1] = count - 1;
+    range[2] = 0;
+    range[3] = std::min((b - size) / tileSize, count - 1);
+    return 2;
+  }
+
+  // eNX`W͈̔ [s0, s1] x [t0, t1] QƂ^CɈ
+  void mark(double s0, double s1, double t0, double t1)
+  {
+    // oꎟԂŎQƂf͈̔͂ɗ]T
+    const int textureWidth(extent.textureWidth), textureHeight(extent.textureHeight);
+    const double x0(std::floor(s0 * textureWidth - 0.5) - margin);
+    const double x1(std::floor(s1 * textureWidth - 0.5) + 1.0 + margin);
+    const double y0(std::floor(t0 * textureHeight - 0.5) - margin);
+    const double y1(std::floor(t1 * textureHeight - 0.5) + 1.0 + margin);
+
+    // dȂ^C̗ƍs͈̔
+    int cx[4], cy[4];
+    const int nx(span(x0, x1, textureWidth, columns, cx));
+    const int ny(span(y0, y1, textureHeight, rows, cy));
+
+    // dȂ^CɈ
+    for (int v = 0; v < ny; ++v)
+      for (int j = cy[v * 2]; j <= cy[v * 2 + 1]; ++j)
+        for (int u = 0; u < nx; ++u)
+          std::fill(visible.begin() + j * columns + cx[u * 2], visible.begin() + j * columns + cx[u * 2 + 1] + 1, 1);
+  }
+
+  // bV̊iqƂɎQƂ^CɈ
+  //   _ƂɃeNX`W߂VF[_͊iq̎l̃eNX`W`Ԃ̂ŁA
+  //   iq̎l̃eNX`W͂ޔ͈͂̊iqŎQƂ͈͂ɂȂB
+  void markVertices(const double *r, double focal, const GLfloat *screen, const GLfloat *circle,
+    GLsizei slices, GLsizei stacks)
+  {
+    // iq_ƂɃeNX`W߂
+    samples.resize(slices * (stacks + 1));
+    for (GLsizei j = 0; j <= stacks; ++j)
+    {
+      for (GLsizei i = 0; i < slices; ++i)
+      {
+        // XN[̓_Ɖ]PʃxNg
+        const double p[] =
+        {
+          (i * 2.0 / (slices - 1) - 1.0) * screen[0] + screen[2],
+          (j * 2.0 / stacks - 1.0) * screen[1] + screen[3]
+        };
+        double v[3];
+        for (int k = 0; k < 3; ++k) v[k] = r[k * 3] * p[0] + r[k * 3 + 1] * p[1] - r[k * 3 + 2] * focal;
+        const double l(std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+        for (int k = 0; k < 3; ++k) v[k] /= l;
+
+        project(model, extent, v, p, circle, samples[j * slices + i]);
+      }
+    }
+
+    // iqƂɎl̃eNX`W͂ޔ͈͂̃^CɈ
+    for (GLsizei j = 0; j < stacks; ++j)
+    {
+      for (GLsizei i = 0; i < slices - 1; ++i)
+      {
+        const Sample *const corner[] =
+        {
+          &samples[j * slices + i], &samples[j * slices + i + 1],
+          &samples[(j + 1) * slices + i], &samples[(j + 1) * slices + i + 1]
+        };
+
+        // 䂪 1 ̒_Ȃ tc[0] ́A0 ̒_Ȃ tc[1] ͎QƂȂ
+        double blendMin(1.0), blendMax(0.0);
+        for (const Sample *c : corner)
+        {
+          blendMin = std::min(blendMin, c->blend);
+          blendMax = std::max(blendMax, c->blend);
+        }
+
+        for (int n = 0; n < 2; ++n)
+        {
+          if (n == 0 ? blendMin >= 1.0 : blendMax <= 0.0) continue;
+
+          double s0(corner[0]->tc[n][0]), s1(s0), t0(corner[0]->tc[n][1]), t1(t0);
+          for (const Sample *c : corner)
+          {
+            s0 = std::min(s0, c->tc[n][0]);
+            s1 = std::max(s1, c->tc[n][0]);
+            t0 = std::min(t0, c->tc[n][1]);
+            t1 = std::max(t1, c->tc[n][1]);
+          }
+          mark(s0, s1, t0, t1);
+        }
+      }
+    }
+  }
+
+  // ~}@ŊiqƂɎQƂ^CɈ
+  //   panorama.frag ̓tOgƂɃeNX`W߂̂ŁA
+  //   iq̕ӂ̒_ƒSłoxƈܓx߁Aox̐܂ԂƋɂ܂ފiqB
+  void markEquirectangular(const double *r, double focal, const GLfloat *screen, const GLfloat *circle,
+    GLsizei slices, GLsizei stacks)
+  {
+    // eNX`ԏ̃XP[ƒSʒu
+    const double sx(-0.15915494 / circle[0]), sy(-0.31830989 / circle[1]);
+    const double cx(circle[2] + 0.5), cy(circle[3] + 0.5);
+
+    // cɓ{ɍוiq_Ōoxƈܓx߂
+    const GLsizei columns2(slices * 2 - 1), rows2(stacks * 2 + 1);
+    samples.resize(columns2 * rows2);
+    for (GLsizei j = 0; j < rows2; ++j)
+    {
+      for (GLsizei i = 0; i < columns2; ++i)
+      {
+        const double p[] =
+        {
+          (i * 1.0 / (slices - 1) - 1.0) * screen[0] + screen[2],
+          (j * 1.0 / stacks - 1.0) * screen[1] + screen[3]
+        };
+        double v[3];
+        for (int k = 0; k < 3; ++k) v[k] = r[k * 3] * p[0] + r[k * 3 + 1] * p[1] - r[k * 3 + 2] * focal;
+        Sample &sample(samples[j * columns2 + i]);
+        sample.tc[0][0] = std::atan2(v[0], v[2]);
+        sample.tc[0][1] = std::atan2(v[1], std::sqrt(v[0] * v[0] + v[2] * v[2]));
+      }
+    }
+
+    // ɂ̕ R^T (0, }1, 0) XN[ɂ΂܂ފiq
+    std::vector<unsigned char> pole(slices * stacks, 0);
+    for (int sign = -1; sign <= 1; sign += 2)
+    {
+      const double d[] = { r[3] * sign, r[4] * sign, r[5] * sign };
+      if (d[2] >= 0.0) continue;
+      const double x((d[0] * focal / -d[2] - screen[2]) / screen[0]);
+      const double y((d[1] * focal / -d[2] - screen[3]) / screen[1]);
+      const int i(static_cast<int>(std::floor((x + 1.0) * (slices - 1) * 0.5)));
+      const int j(static_cast<int>(std::floor((y + 1.0) * stacks * 0.5)));
+
+      // Ě덷ŗׂ̊iqɂ܂ނ̂Ƃ
+      for (int n = j - 1; n <= j + 1; ++n)
+        for (int m = i - 1; m <= i + 1; ++m)
+          if (m >= 0 && m < slices - 1 && n >= 0 && n < stacks) pole[n * (slices - 1) + m] = 1;
+    }
+
+    // iqƂ 3 x 3 ̓_̌oxƈܓx͂ޔ͈͂̃^CɈ
+    for (GLsizei j = 0; j < stacks; ++j)
+    {
+      for (GLsizei i = 0; i < slices - 1; ++i)
+      {
+        double longitude[9], latitude[9];
+        for (int n = 0; n < 3; ++n)
+          for (int m = 0; m < 3; ++m)
+          {
+            const Sample &sample(samples[(j * 2 + n) * columns2 + i * 2 + m]);
+            longitude[n * 3 + m] = sample.tc[0][0];
+            latitude[n * 3 + m] = sample.tc[0][1];
+          }
+        double lon0(*std::min_element(longitude, longitude + 9)), lon1(*std::max_element(longitude, longitude + 9));
+        double lat0(*std::min_element(latitude, latitude + 9)), lat1(*std::max_element(latitude, latitude + 9));
+
+        if (pole[j * (slices - 1) + i])
+        {
+          // ɂ܂ފiqׂ͂Ă̌oxƋɂ܂ł̈ܓxQƂ
+          lon0 = -3.14159265;
+          lon1 = 3.14159265;
+          if (lat1 > 0.0) lat1 = 1.57079633;
+          if (lat0 < 0.0) lat0 = -1.57079633;
+        }
+        else if (lon1 - lon0 > 3.14159265)
+        {
+          // ox } Ő܂ԂĂ畉̌ox 2 𑫂ĂȂ
+          lon0 = 3.14159265;
+          lon1 = -3.14159265;
+          for (double lon : longitude)
+          {
+            if (lon < 0.0) lon += 6.28318531;
+            lon0 = std::min(lon0, lon);
+            lon1 = std::max(lon1, lon);
+          }
+        }
+
+        // XP[Ȃ̂Ŕ͈͂̒[ւ
+        const double s0(lon0 * sx + cx), s1(lon1 * sx + cx), t0(lat0 * sy + cy), t1(lat1 * sy + cy);
+        mark(std::min(s0, s1), std::max(s0, s1), std::min(t0, t1), std::max(t0, t1));
+      }
+    }
+  }
+
+  // ̎ɂĕ`Ɏg^CɈ
+  void markView(const double *r, double focal, const GLfloat *screen, const GLfloat *circle,
+    GLsizei slices, GLsizei stacks)
+  {
+    if (model == EQUIRECTANGULAR)
+      markEquirectangular(r, focal, screen, circle, slices, stacks);
+    else
+      markVertices(r, focal, screen, circle, (slices - 1) * subdivision + 1, stacks * subdivision);
+  }
+
+public:
+
+  // RXgN^
+  //   vsrc ͓WJɎgo[ebNXVF[_̃\[Xt@CA
+  //   margin ͗]Ɋ܂߂fAahead ͎\t[B
+  ViewTiles(const char *vsrc, int margin = 2, int ahead = 2)
+    : model(getModel(vsrc)), margin(std::max(margin, 1)), ahead(std::max(ahead, 0)), subdivision(1)
+    , previousFocal(0.0), hasPrevious(false)
+    , extent()
+    , tileSize(0), columns(0), rows(0)
+  {}
+
+  // fXgN^
+  virtual ~ViewTiles()
+  {}
+
+  // WJɎgVF[_؂ւƂɓẽfύX
+  //   O͕̎ʂ̓ê̂Ȃ̂ŁÃt[ł͎\ȂB
+  void setModel(const char *vsrc)
+  {
+    model = getModel(vsrc);
+    hasPrevious = false;
+  }
+
+  // o[ebNXVF[_̃\[Xt@C瓊ẽf𓾂
+  static Model getModel(const char *vsrc)
+  {
+    if (strcmp(vsrc, "fixed.vert") == 0) return FIXED;
+    if (strcmp(vsrc, "rectangle.vert") == 0) return RECTANGLE;
+    if (strcmp(vsrc, "fisheye.vert") == 0) return FISHEYE;
+    if (strcmp(vsrc, "theta.vert") == 0) return DUAL_FISHEYE;
+    if (strcmp(vsrc, "panorama.vert") == 0) return EQUIRECTANGULAR;
+    return WHOLE;
+  }
+
+  // xNgɑ΂eNX`W߂
+  //   v ͉]PʃxNgAp ̓XN[̓_ŁA
+  //   fixed.vert, rectangle.vert, fisheye.vert, theta.vert ƓvZB
+  static void project(Model model, const Extent &extent, const double *v, const double *p,
+    const GLfloat *circle, Sample &sample)
+  {
+    const int textureWidth(extent.textureWidth), textureHeight(extent.textureHeight);
+    const int frameWidth(extent.frameWidth), frameHeight(extent.frameHeight);
+    const int cropX(extent.cropX), cropY(extent.cropY);
+
+    sample.blend = 0.0;
+
+    switch (model)
+    {
+    case FIXED:
+    {
+      // ]ɃXN[̓_̂܂܎g
+      const double sx(0.5 * frameHeight / frameWidth / circle[0]), sy(-0.5 / circle[1]);
+      sample.tc[0][0] = p[0] * sx + circle[2] + 0.5;
+      sample.tc[0][1] = p[1] * sy + circle[3] + 0.5;
+      break;
+    }
+
+    case RECTANGLE:
+    {
+      // 摜ʂւ̓e
+      const double sx(-0.5 * frameHeight / frameWidth / circle[0]), sy(0.5 / circle[1]);
+      sample.tc[0][0] = v[0] * sx / v[2] + circle[2] + 0.5;
+      sample.tc[0][1] = v[1] * sy / v[2] + circle[3] + 0.5;
+      break;
+    }
+
+    case FISHEYE:
+    {
+      // ˉe (؂o͈͂̃eNX`Ԃɍ킹)
+      const double cw(static_cast<double>(textureWidth) / frameWidth), ch(static_cast<double>(textureHeight) / frameHeight);
+      const double sx(0.5 * frameHeight / frameWidth / circle[0] / cw), sy(-0.5 / circle[1] / ch);
+      const double cx((circle[2] + 0.5 - static_cast<double>(cropX) / frameWidth) / cw);
+      const double cy((circle[3] + 0.5 - static_cast<double>(cropY) / frameHeight) / ch);
+      const double l(std::sqrt(v[0] * v[0] + v[1] * v[1]));
+      const double r(l > 0.0 ? std::acos(std::max(std::min(-v[2], 1.0), -1.0)) / l : 0.0);
+      sample.tc[0][0] = r * v[0] * sx + cx;
+      sample.tc[0][1] = r * v[1] * sy + cy;
+      break;
+    }
+
+    case DUAL_FISHEYE:
+    {
+      // ƑÕY̑̔aƒS
+      const double rbx(circle[0] * -0.25), rby(circle[1] * 0.25 * frameWidth / frameHeight);
+      const double cbx(rbx - circle[2] + 0.5), cby(rby - circle[3]);
+
+      // ̑ΓIȋpƑO̍
+      const double angle(1.0 - std::acos(std::max(std::min(v[2], 1.0), -1.0)) * 0.63661977);
+      const double t(std::max(std::min((angle + 0.02) / 0.04, 1.0), 0.0));
+      sample.blend = t * t * (3.0 - 2.0 * t);
+
+      // yx ł̕
+      const double l(std::sqrt(v[0] * v[0] + v[1] * v[1]));
+      const double ox(l > 0.0 ? v[1] / l * 0.885 : 0.0), oy(l > 0.0 ? v[0] / l * 0.885 : 0.0);
+
+      // O (tc[0]) ƌ (tc[1]) ̃eNX`W
+      sample.tc[0][0] = (1.0 + angle) * ox * -rbx + cbx + 0.5;
+      sample.tc[0][1] = (1.0 + angle) * oy * rby + cby;
+      sample.tc[1][0] = (1.0 - angle) * ox * rbx + cbx;
+      sample.tc[1][1] = (1.0 - angle) * oy * rby + cby;
+      break;
+    }
+
+    default:
+      break;
+    }
+  }
+
+  // J̃t[؂oeNX`̑傫Ɣ͈͂𓾂
+  static Extent getExtent(const Camera &camera)
+  {
+    const Extent extent =
+    {
+      camera.getCropWidth(), camera.getCropHeight(),
+      camera.getWidth(), camera.getHeight(),
+      camera.getCropX(), camera.getCropY()
+    };
+    return extent;
+  }
+
+  // bV̊iqוĒׂ
+  //   RemapTable ̂悤ɒ_ŕԂfƂɃeNX`W߂Ƃ́A
+  //   iq̎l̊ԂŃeNX`WȂ镪ׂiqŉB
+  void setSubdivision(int count)
+  {
+    subdivision = std::max(count, 1);
+  }
+
+  // ݂̎ŕ`Ɏg^C߂ăJɎw肷
+  //   rotation ͍sD̎̉]sAscreen, focal, circle ̓VF[_ uniform ϐƓ́A
+  //   slices, stacks ̓bV̊iq_̐ƕ`悷CX^X̐B
+  void update(Camera &camera, const GLfloat *rotation, const GLfloat *screen, GLfloat focal,
+    const GLfloat *circle, GLsizei slices, GLsizei stacks)
+  {
+    update(camera, 1, rotation, screen, &focal, circle, slices, stacks);
+  }
+
+  // ̃r[݂̌̎ŕ`Ɏg^C߂ăJɎw肷
+  //   rotation, screen, focal ̓r[Ƃ̒l views ׂ̂ (MultiView.h)A
+  //   slices, stacks ͈̃r[̃bV̊iq_̐ƕ`悷CX^X̐B
+  //   ̗\ɂ͍ŏ̃r[̉]̕ωgAׂẴr[ɓωB
+  void update(Camera &camera, GLsizei views, const GLfloat *rotation, const GLfloat *screen, const GLfloat *focal,
+    const GLfloat *circle, GLsizei slices, GLsizei stacks)
+  {
+    // ^CɕĂȂΉȂ
+    tileSize = camera.getTileSize();
+    if (tileSize == 0) return;
+
+    // eNX`ƃ^C̑傫
+    extent = getExtent(camera);
+    columns = camera.getTileColumns();
+    rows = camera.getTileRows();
+
+    // ݂̃r[Ƃ̎̉]s
+    std::vector<double> r(views * 9);
+    for (GLsizei v = 0; v < views; ++v)
+      for (int k = 0; k < 3; ++k)
+        for (int l = 0; l < 3; ++l)
+          r[v * 9 + k * 3 + l] = rotation[v * 16 + k * 4 + l];
+
+    // ẽfȂ΂ׂẴ^Cg
+    visible.assign(columns * rows, model == WHOLE ? 1 : 0);
+    if (model != WHOLE)
+    {
+      // ݂̎ŕ`Ɏg^C
+      for (GLsizei v = 0; v < views; ++v)
+        markView(&r[v * 9], focal[v], screen + v * 4, circle, slices, stacks);
+
+      // O񂩂̉] dR = R Rp^T Əœ_̕ωƂĐt[̎̃^C
+      if (hasPrevious && model != FIXED)
+      {
+        double d[9];
+        for (int k = 0; k < 3; ++k)
+          for (int l = 0; l < 3; ++l)
+            d[k * 3 + l] = r[k * 3] * previous[l * 3] + r[k * 3 + 1] * previous[l * 3 + 1] + r[k * 3 + 2] * previous[l * 3 + 2];
+        const double df(focal[0] - previousFocal);
+
+        // ωĂȂΗ\Ȃ
+        const bool moving(std::abs(d[0] + d[4] + d[8] - 3.0) > 1.0e-9 || df != 0.0);
+
+        for (GLsizei v = 0; moving && v < views; ++v)
+        {
+          double predicted[9];
+          std::copy(&r[v * 9], &r[v * 9] + 9, predicted);
+          for (int n = 1; n <= ahead; ++n)
+          {
+            // predicted = dR predicted
+            double next[9];
+            for (int k = 0; k < 3; ++k)
+              for (int l = 0; l < 3; ++l)
+                next[k * 3 + l] = d[k * 3] * predicted[l] + d[k * 3 + 1] * predicted[3 + l] + d[k * 3 + 2] * predicted[6 + l];
+            std::copy(next, next + 9, predicted);
+
+            markView(predicted, std::max(focal[v] + df * n, focal[v] * 0.5), screen + v * 4, circle, slices, stacks);
+          }
+        }
+      }
+    }
+
+    // ̍ŏ̃r[̎ۑ
+    std::copy(r.begin(), r.begin() + 9, previous);
+    previousFocal = focal[0];
+    hasPrevious = true;
+
+    // `Ɏg^CJɎw肷
+    camera.setVisibleTiles(visible);
+  }
+
+  // `Ɏg^C̐𓾂
+  int getVisibleCount() const
+  {
+    return static_cast<int>(std::count(visible.begin(), visible.end(), 1));
+  }
+};
@@ -85,6 +85,17 @@ inline int Compare(const ovrGraphicsLuid& lhs, const ovrGraphicsLuid& rhs)
 #  endif
 #endif
 
+// EBhEJ EGL ̃ReLXgƃt[obt@IuWFNgŕ`
+#if defined(HEADLESS)
+#  if defined(USE_OCULUS_RIFT)
+#    error "HEADLESS can't be used with USE_OCULUS_RIFT."
+#  endif
+#  include <csignal>
+#endif
+
+// OpenGL ̃ReLXgɊւ鏈
+#include "Context.h"
+
 // WCu
 #include <cstdlib>
 #include <iostream>
@@ -97,6 +108,11 @@ class Window
   // EBhE̎ʎq
   GLFWwindow *window;
 
+#if !defined(HEADLESS)
+  // IuWFNgLReLXg\ȂEBhE
+  GLFWwindow *sharedWindow;
+#endif
+
   // r[|[g̕ƍ
   GLsizei width, height;
 
@@ -136,6 +152,56 @@ class Window
   // EhbOɂgbN{[
   GgTrackball trackball_right;
 
+  // EBhE̓e`Kv
+  bool damaged;
+
+  // L[őI񂾓WJ̎@̔ԍ
+  int selection;
+
+#if defined(HEADLESS)
+  // EGL ̃fBXvCƃReLXgƂ̐ݒ
+  EGLDisplay display;
+  EGLContext context;
+  EGLConfig config;
+
+  // Jgɂ pbuffer (T[tFXȂŃJgɂł EGL_NO_SURFACE)
+  EGLSurface surface;
+
+  // IuWFNgLReLXgƂJgɂ pbuffer
+  EGLContext sharedContext;
+  EGLSurface sharedSurface;
+
+  // OpenGL Version 4.1 Core Profile ̃ReLXg̑
+  static const EGLint *getContextAttributes()
+  {
+    static const EGLint contextAttributes[] =
+    {
+      EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+      EGL_CONTEXT_MINOR_VERSION_KHR, 1,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+      EGL_NONE
+    };
+    return contextAttributes;
+  }
+
+  // `̃t[obt@IuWFNgƂ̃J[obt@AfvXobt@
+  GLuint framebuffer;
+  GLuint renderbuffer[2];
+
+  // IvVOi󂯎
+  static volatile std::sig_atomic_t &closing()
+  {
+    static volatile std::sig_atomic_t flag(0);
+    return flag;
+  }
+
+  // IvVOi󂯎Ƃ̏
+  static void interrupt(int)
+  {
+    closing() = 1;
+  }
+#endif
+
 #if defined(USE_OCULUS_RIFT)
   //
   // Oculus Rift
@@ -194,12 +260,137 @@ class Window
 
 public:
 
+#if defined(HEADLESS)
+  //
+  // RXgN^
+  //   EBhEJ EGL  OpenGL ̃ReLXgA
+  //   width ~ height ̃t[obt@IuWFNg`ɂB
+  //   Mesa ł̓T[tFX̂ȂvbgtH[ĝŁAfBXvC GPU ȂĂ
+  //   \tgEFA_Oŕ`BEBhẼ^CgAtXN[ALEBhË͎gȂB
+  //
+  Window(const char * = "GLFW Window", int width = 640, int height = 480,
+    int = 0, GLFWwindow * = nullptr)
+    : window(nullptr), damaged(true), selection(0)
+    , display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), config(EGL_NO_CONFIG_KHR), surface(EGL_NO_SURFACE)
+    , sharedContext(EGL_NO_CONTEXT), sharedSurface(EGL_NO_SURFACE), framebuffer(0), renderbuffer{ 0, 0 }
+  {
+    // Mesa ȂT[tFX̂ȂvbgtH[̃fBXvCg
+    const char *const clientExtensions(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS));
+    const auto getPlatformDisplay(reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")));
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+      display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+    // gȂΊ̃fBXvCg
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY) return;
+
+    // EGL  OpenGL g
+    if (!eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) return;
+    const char *const displayExtensions(eglQueryString(display, EGL_EXTENSIONS));
+
+    // pbuffer ݒI (ȂΐݒȂŃReLXg)
+    static const EGLint configAttributes[] =
+    {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+      EGL_NONE
+    };
+    EGLint configs(0);
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs < 1) config = EGL_NO_CONFIG_KHR;
+
+    // OpenGL Version 4.1 Core Profile ̃ReLXg쐬
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, getContextAttributes());
+    if (context == EGL_NO_CONTEXT) return;
+
+    // T[tFXȂŃJgɂłȂΏ pbuffer ăJgɂ
+    if (!(displayExtensions && strstr(displayExtensions, "EGL_KHR_surfaceless_context")) && config != EGL_NO_CONFIG_KHR)
+    {
+      static const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+      surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) return;
+
+    // Q[OtBbNX_̓sɂ鏉s
+    ggInit();
+
+    // `̃J[obt@ƃfvXobt@쐬
+    glGenRenderbuffers(2, renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // t[obt@IuWFNg쐬āAȍ~͂ɕ`
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffer[1]);
+
+    // 傫ȂǂŃt[obt@IuWFNgSɂȂȂΎgȂ
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glDeleteFramebuffers(1, &framebuffer);
+      framebuffer = 0;
+      return;
+    }
+
+    // L[ƃ}EX̏lݒ肷 (͂͂Ȃ̂ŕςȂ)
+    shift_key = control_key = false;
+    arrow[0] = arrow[1] = 0;
+    shift_arrow[0] = shift_arrow[1] = 0;
+    control_arrow[0] = control_arrow[1] = 0;
+    mouse_x = mouse_y = 0.0;
+    wheel_rotation = shift_wheel_rotation = control_wheel_rotation = 0.0;
+
+    // t[obt@IuWFNg̃TCYۑ
+    this->width = width;
+    this->height = height;
+    aspect = static_cast<GLfloat>(width) / static_cast<GLfloat>(height);
+
+    // gbN{[͈̔͂ݒ肷
+    trackball_left.region(width, height);
+    trackball_right.region(width, height);
+
+    // t[obt@IuWFNgŜɕ`悷
+    restoreViewport();
+
+    // IvVOi󂯎
+    std::signal(SIGINT, interrupt);
+    std::signal(SIGTERM, interrupt);
+  }
+
+  //
+  // fXgN^
+  //
+  virtual ~Window()
+  {
+    // EGL ĂȂΖ߂
+    if (display == EGL_NO_DISPLAY) return;
+
+    // t[obt@IuWFNg폜
+    if (eglGetCurrentContext() == context && context != EGL_NO_CONTEXT)
+    {
+      glDeleteFramebuffers(1, &framebuffer);
+      glDeleteRenderbuffers(2, renderbuffer);
+    }
+
+    // ReLXgƃT[tFXj
+    deleteSharedContext();
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+  }
+#else
   //
   // RXgN^
   //
   Window(const char *title = "GLFW Window", int width = 640, int height = 480,
     int fullscreen = 0, GLFWwindow *share = nullptr)
-    : window(nullptr)
+    : window(nullptr), sharedWindow(nullptr), damaged(true), selection(0)
   {
     // ςȂ true
     static bool initialized(false);
@@ -325,6 +516,9 @@ public:
     // EBhẼTCYύXɌĂяoo^
     glfwSetFramebufferSizeCallback(window, resize);
 
+    // EBhE̓eꂽƂɌĂяoo^
+    glfwSetWindowRefreshCallback(window, refresh);
+
 #if defined(USE_OCULUS_RIFT)
     // Oculus Rift ̏o
     hmdDesc = ovr_GetHmdDesc(session);
@@ -584,8 +778,74 @@ public:
 #endif
 
     // EBhEj
+    deleteSharedContext();
     glfwDestroyWindow(window);
   }
+#endif
+
+  //
+  // ̃EBhẼReLXgƃIuWFNgLReLXg
+  //   `XbhōAق̃Xbh makeSharedCurrent() ăVF[_̃RpCȂǂɎgB
+  //   Ȃ false ԂB
+  //
+  bool createSharedContext()
+  {
+#if defined(HEADLESS)
+    if (sharedContext != EGL_NO_CONTEXT) return true;
+    if (context == EGL_NO_CONTEXT) return false;
+    sharedContext = eglCreateContext(display, config, context, getContextAttributes());
+    if (sharedContext == EGL_NO_CONTEXT) return false;
+
+    // `Xbh pbuffer gĂΕʂ pbuffer 
+    if (surface != EGL_NO_SURFACE)
+    {
+      static const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+      sharedSurface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+    }
+    return true;
+#else
+    if (sharedWindow) return true;
+    if (!window) return false;
+
+    // \ȂȃEBhẼEBhEƃReLXgLč
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    sharedWindow = glfwCreateWindow(1, 1, "", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    return sharedWindow != nullptr;
+#endif
+  }
+
+  //
+  // IuWFNgLReLXgĂяoXbh̃Jgɂ
+  //   current  false ȂB
+  //
+  bool makeSharedCurrent(bool current) const
+  {
+#if defined(HEADLESS)
+    if (!current) return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) != EGL_FALSE;
+    return eglMakeCurrent(display, sharedSurface, sharedSurface, sharedContext) != EGL_FALSE;
+#else
+    glfwMakeContextCurrent(current ? sharedWindow : nullptr);
+    return true;
+#endif
+  }
+
+  //
+  // IuWFNgLReLXgj
+  //   ǂ̃XbhłJgɂĂȂƂɕ`XbhŌĂԁB
+  //
+  void deleteSharedContext()
+  {
+#if defined(HEADLESS)
+    if (sharedSurface != EGL_NO_SURFACE) eglDestroySurface(display, sharedSurface);
+    if (sharedContext != EGL_NO_CONTEXT) eglDestroyContext(display, sharedContext);
+    sharedSurface = EGL_NO_SURFACE;
+    sharedContext = EGL_NO_CONTEXT;
+#else
+    if (sharedWindow) glfwDestroyWindow(sharedWindow);
+    sharedWindow = nullptr;
+#endif
+  }
 
 #if defined(USE_OCULUS_RIFT)
   //
@@ -767,13 +1027,61 @@ public:
     return window;
   }
 
+  //
+  // `̏łǂ
+  //   EBhEJȂƂ̓t[obt@IuWFNgꂽǂB
+  //
+  bool isValid() const
+  {
+#if defined(HEADLESS)
+    return framebuffer != 0;
+#else
+    return window != nullptr;
+#endif
+  }
+
   //
   // EBhEׂ𔻒肷
   //
   bool shouldClose()
   {
+#if defined(HEADLESS)
+    // IvVOi󂯎Ăΐ^Ԃ
+    return closing() != 0;
+#else
     // EBhE邩 ESC L[^CvĂΐ^Ԃ
     return glfwWindowShouldClose(window) || glfwGetKey(window, GLFW_KEY_ESCAPE);
+#endif
+  }
+
+  //
+  // WJ̎@̔ԍݒ肷
+  //   L[^CvƂƓÃt[؂ւvB
+  //
+  void setSelection(int selection)
+  {
+    this->selection = selection;
+  }
+
+  //
+  // L[ setSelection() őI񂾓WJ̎@̔ԍ𓾂
+  //
+  int getSelection() const
+  {
+    return selection;
+  }
+
+  //
+  // J[obt@ւƂɑ҂̉񐔂w肷
+  //   EBhEJȂƂ Oculus Rift ł͉ȂB
+  //
+  void setSwapInterval(int interval)
+  {
+#if defined(HEADLESS) || defined(USE_OCULUS_RIFT)
+    (void)interval;
+#else
+    glfwSwapInterval(interval);
+#endif
   }
 
   //
@@ -833,16 +1141,45 @@ public:
 
     // cĂ OpenGL R}hs
     glFlush();
+#elif defined(HEADLESS)
+    // t[obt@IuWFNgɕ`̂œւɎcĂ OpenGL R}hs
+    glFlush();
 #else
     // J[obt@ւ
     glfwSwapBuffers(window);
 #endif
 
+    // `̂ň
+    damaged = false;
+
+    // Cxgo
+    waitEvents(0.0);
+  }
+
+  //
+  // Cxgo
+  //   timeout ȂCxg邩 timeout bo߂܂ő҂B
+  //   postWakeup() ĂׂΑ̃Xbh҂łB
+  //
+  void waitEvents(double timeout)
+  {
     // VtgL[ƃRg[L[̏ԂZbg
     shift_key = control_key = false;
 
+#if defined(HEADLESS)
+    // ͂͂Ȃ̂ő̃XbhɋN܂ő҂ɂ
+    if (timeout > 0.0) waitWakeup(timeout);
+#else
     // Cxgo
+#  if defined(USE_OCULUS_RIFT)
+    // Oculus Rift ł͑҂Ȃ
     glfwPollEvents();
+#  else
+    if (timeout > 0.0)
+      glfwWaitEventsTimeout(timeout);
+    else
+      glfwPollEvents();
+#  endif
 
     // }EẌʒu𒲂ׂ
     glfwGetCursorPos(window, &mouse_x, &mouse_y);
@@ -854,6 +1191,20 @@ public:
 
     // E{^hbO
     if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_2)) trackball_right.motion(x, y);
+#endif
+  }
+
+  //
+  // EBhE̓e`Kv邩ǂ
+  //   Oculus Rift ł̓wbhgbLOŎɕς̂ŁA`B
+  //
+  bool isDamaged() const
+  {
+#if defined(USE_OCULUS_RIFT)
+    return true;
+#else
+    return damaged;
+#endif
   }
 
   //
@@ -870,6 +1221,9 @@ public:
       instance->width = width;
       instance->height = height;
 
+      // `
+      instance->damaged = true;
+
       // gbN{[͈̔͂ݒ肷
       instance->trackball_left.region(width, height);
       instance->trackball_right.region(width, height);
@@ -884,6 +1238,18 @@ public:
     }
   }
 
+  //
+  // EBhE̓eꂽƂ̏
+  //
+  static void refresh(GLFWwindow *window)
+  {
+    // ̃CX^X this |C^𓾂
+    Window *const instance(static_cast<Window *>(glfwGetWindowUserPointer(window)));
+
+    // `
+    if (instance) instance->damaged = true;
+  }
+
   //
   // L[{[h^Cv̏
   //
@@ -918,6 +1284,20 @@ public:
         case GLFW_KEY_SPACE:
           break;
 
+        case GLFW_KEY_0:
+        case GLFW_KEY_1:
+        case GLFW_KEY_2:
+        case GLFW_KEY_3:
+        case GLFW_KEY_4:
+        case GLFW_KEY_5:
+        case GLFW_KEY_6:
+        case GLFW_KEY_7:
+        case GLFW_KEY_8:
+        case GLFW_KEY_9:
+          // WJ̎@I
+          instance->selection = key - GLFW_KEY_0;
+          break;
+
         case GLFW_KEY_BACKSPACE:
         case GLFW_KEY_DELETE:
           break;
@@ -0,0 +1,83 @@
+#version 150 core
+#extension GL_ARB_explicit_attrib_location : enable
+
+//
+// wieNX`̃TvO
+//   WJɎgtOgVF[_ lookup.frag ̑OɒuĈꏏɃRpC (ProgramCache.h)B
+//
+
+// wieNX`
+uniform sampler2D image;
+
+// wieNX`̉f̌` (0: BGR, 1: YUYV, 2: NV12)
+uniform int yuv;
+
+// NV12 ̐F̕ʂ̃eNX`
+uniform sampler2D chroma;
+
+// wieNX`Ŝ̑傫
+uniform ivec2 extent;
+
+// őTCY𒴂̂ŕƂ̈ꖇɎ߂fƗ񐔂ƍs (Ȃ 0)
+uniform ivec3 pieces;
+
+// wieNX`ƐF̃eNX`
+//   ꖇC[Ɋi[A͂ɗׂ̈ꖇ̉f 1 fʂĂB
+uniform sampler2DArray images;
+uniform sampler2DArray chromas;
+
+// C[WT[N؂ot[ȂeNX`̊Oɂ
+uniform bool border;
+
+// YUV (BT.601)  RGB ɕϊ
+vec4 rgb(float y, vec2 uv)
+{
+  y = 1.1643836 * (y - 0.0627451);
+  uv -= 0.5;
+  return vec4(y + 1.5960268 * uv.y, y - 0.3917623 * uv.x - 0.8129676 * uv.y, y + 2.0172321 * uv.x, 1.0);
+}
+
+// wieNX`̉f̈ʒu p ܂ވꖇ߁ÃC[̈ʒuƃC[ԍԂ
+//   step ͈ꖇɎ߂fŁA͂ɕʂ 1 f̕炷B
+vec3 piece(vec2 p, int step)
+{
+  ivec2 c = min(ivec2(p) / step, pieces.yz - 1);
+  return vec3(p - vec2(c * step) + 1.0, c.y * pieces.y + c.x);
+}
+
+// ĂĂȂĂwieNX`eNX`W tc ŃTvO
+//   scale ͕ʂ̉𑜓x̋t (FȂ 2)B
+vec4 lookup(sampler2D whole, sampler2DArray array, int scale, vec2 tc)
+{
+  if (pieces.x == 0) return texture(whole, tc);
+  vec3 p = piece(fract(tc) * vec2(extent / scale), pieces.x / scale);
+  return texture(array, vec3(p.xy / vec2(textureSize(array, 0).xy), p.z));
+}
+
+// ĂĂȂĂwieNX`̉f p o
+vec4 fetch(ivec2 p)
+{
+  if (pieces.x == 0) return texelFetch(image, p, 0);
+  return texelFetch(images, ivec3(piece(vec2(p) + 0.5, pieces.x)), 0);
+}
+
+// wieNX`̉f̐F߂
+vec4 background(vec2 tc)
+{
+  // ؂ot[̊O͌̃t[̎͂Ɠɂ
+  if (border && any(notEqual(tc, clamp(tc, 0.0, 1.0)))) return vec4(0.0, 0.0, 0.0, 1.0);
+
+  // YUYV ͋PxԂA(Y, U)  (Y, V) ̑gFo
+  if (yuv == 1)
+  {
+    ivec2 p = ivec2(fract(tc) * vec2(extent));
+    p.x &= ~1;
+    return rgb(lookup(image, images, 1, tc).r, vec2(fetch(p).g, fetch(p + ivec2(1, 0)).g));
+  }
+
+  // NV12 ͋PxƐFꂼ̃eNX`o
+  if (yuv == 2) return rgb(lookup(image, images, 1, tc).r, lookup(chroma, chromas, 2, tc).rg);
+
+  // BGR ͂̂܂܎g
+  return lookup(image, images, 1, tc);
+}
@@ -4,26 +4,63 @@
 // ̉]sȂ
 //
 
-// XN[̊iqԊu
-uniform vec2 gap;
+// KIɕbV̒_ʒu
+in vec2 point;
 
-// XN[̑傫ƒSʒu
-uniform vec4 screen;
+// WJɎgVF[_ɋʂ̃p[^ (Expansion.h)
+layout (std140, row_major) uniform Expansion
+{
+  // XN[]ϊs
+  mat4 rotation;
+
+  // XN[̑傫ƒSʒu
+  vec4 screen;
+
+  // wieNX`̔aƒSʒu
+  vec4 circle;
+
+  // wieNX`ɐ؂ot[͈̔ (t[ɑ΂鍶̈ʒuƑ傫)
+  vec4 crop;
+
+  // XN[̊iqԊu
+  vec2 gap;
+
+  // XN[܂ł̏œ_
+  float focal;
 
-// XN[܂ł̏œ_
-uniform float focal;
+  // KIɕbVgǂ
+  bool adaptive;
 
-// XN[]ϊs
-uniform mat4 rotation;
+  // xɕ`r[̐ (0 Ȃ rotation, screen, focal ŃNbsOԑSʂɈ̃r[`)
+  int views;
 
-// wieNX`̔aƒSʒu
-uniform vec4 circle;
+  // ̃r[`CX^X̐ (iq̍s)
+  int instances;
 
-// wieNX`
-uniform sampler2D image;
+  // WJ̓e (0: e, 1: ~}@)
+  int projection;
+};
+
+// r[Ƃ̎̉]AXN[̑傫ƒSʒuA``̑傫ƒSʒuAœ_
+struct View
+{
+  mat4 rotation;
+  vec4 screen;
+  vec4 tile;
+  float focal;
+};
+
+// r[Ƃ̃p[^ (MultiView.h)
+layout (std140, row_major) uniform Views
+{
+  View view[16];
+};
+
+// wieNX`Ŝ̑傫 (őTCY𒴂̂ŕĂĂ̑傫)
+uniform ivec2 extent;
 
 // wieNX`̃TCY
-vec2 size = textureSize(image, 0);
+vec2 size = vec2(extent);
 
 // wieNX`̃eNX`ԏ̃XP[
 vec2 scale = vec2(0.5 * size.y / size.x, -0.5) / circle.st;
@@ -43,19 +80,26 @@ void main(void)
   //   ̂悤 GL_TRIANGLE_STRIP ̒_WlB
   //   y  gl_InstaceID 𑫂 glDrawArrayInstanced() ̃CX^XƂ y ωB
   //   Ɋiq̊Ԋu gap  1 Ώc [-1, 1] ͈̔͂̓_Q position B
+  //   KIɕbV (AdaptiveMesh.h) ł͒_ point ̂܂܎gB
   int x = gl_VertexID >> 1;
-  int y = gl_InstanceID + 1 - (gl_VertexID & 1);
-  vec2 position = vec2(x, y) * gap - 1.0;
+  int y = (views > 0 ? gl_InstanceID % instances : gl_InstanceID) + 1 - (gl_VertexID & 1);
+  vec2 position = adaptive ? point : vec2(x, y) * gap - 1.0;
+
+  // ̃CX^X`r[
+  //   ̃r[`Ƃ̓CX^X instances r[Ɋ蓖āA
+  //   ̃r[̎̉]XN[A``jtH[obt@oB
+  View current = views > 0 ? view[gl_InstanceID / instances]
+    : View(rotation, screen, vec4(1.0, 1.0, 0.0, 0.0), focal);
 
-  // _ʒû܂܃X^CUɑ΃NbsOԑSʂɕ`
-  gl_Position = vec4(position, 0.0, 1.0);
+  // _ʒur[̋`ɍ킹ăX^CUɑ (̃r[ȂNbsOԑSʂɕ`)
+  gl_Position = vec4(position * current.tile.st + current.tile.pq, 0.0, 1.0);
 
   // xNg
   //   position ɃXN[̑傫 screen.st ĒSʒu screen.pq 𑫂΁A
   //   XN[̓_̈ʒu p 邩A_ɂ鎋_炱̓_Ɍ́A
   //   œ_ focal  Z Wɗp (p, -focal) ƂȂB
-  vec2 p = position * screen.st + screen.pq;
-  vec4 vector = vec4(p, -focal, 0.0);
+  vec2 p = position * current.screen.st + current.screen.pq;
+  vec4 vector = vec4(p, -current.focal, 0.0);
 
   // eNX`W
   texcoord = vector.xy * scale + center;
@@ -0,0 +1,70 @@
+//
+// Qƕ\̃eNX`ẄʒủfFg
+//   wieNX`TvO֐ background.glsl ɂB
+//
+
+// ÕYƂ̃J̃t[䂸C[Ɋi[eNX`zƐF̃eNX`z (CameraGroup.h)
+uniform sampler2DArray cameras;
+uniform sampler2DArray cameraChromas;
+
+// YƂ̃J̃eNX`z񂩂QƂȂ true
+uniform bool group;
+
+// J̃eNX`z̃C[ layer ̉f̐F߂
+vec4 camera(vec2 tc, uint layer)
+{
+  // ǂ̃YɂʂĂȂ̓eNX`̊OwĂ̂ōɂ
+  if (any(notEqual(tc, clamp(tc, 0.0, 1.0)))) return vec4(0.0, 0.0, 0.0, 1.0);
+  vec3 t = vec3(tc, float(layer));
+
+  // YUYV ͋PxԂA(Y, U)  (Y, V) ̑gFo
+  if (yuv == 1)
+  {
+    ivec2 size = textureSize(cameras, 0).xy;
+    ivec3 p = ivec3(min(ivec2(tc * vec2(size)), size - 1), layer);
+    p.x &= ~1;
+    return rgb(texture(cameras, t).r, vec2(texelFetch(cameras, p, 0).g, texelFetch(cameras, p + ivec3(1, 0, 0), 0).g));
+  }
+
+  // NV12 ͋PxƐFꂼ̃eNX`z񂩂o
+  if (yuv == 2) return rgb(texture(cameras, t).r, texture(cameraChromas, t).rg);
+
+  // BGR ͂̂܂܎g
+  return texture(cameras, t);
+}
+
+// WJ̉fƂ̃eNX`W̎Qƕ\ (theta.vert ł͌ƑÕY̓g)
+uniform sampler2D table;
+
+// ÕY̑̍i[eNX`
+uniform sampler2D weight;
+
+// O̃Y̑Ȃ true
+uniform bool dual;
+
+// OŉfƂɎg̃Y̔ԍ
+uniform usampler2D lens;
+
+// Qƕ\ɑΉr[|[g̍̈ʒu
+uniform ivec2 origin;
+
+// tOg̐F
+layout (location = 0) out vec4 fc;
+
+void main(void)
+{
+  // ̉f̃eNX`WQƕ\o
+  ivec2 q = ivec2(gl_FragCoord.xy) - origin;
+  vec4 texcoord = texelFetch(table, q, 0);
+
+  // YƂ̃JȂ炻ꂼ̃Y̔ԍ̃C[QƂ
+  if (group)
+  {
+    uvec2 l = texelFetch(lens, q, 0).rg;
+    fc = mix(camera(texcoord.pq, l.x), camera(texcoord.st, l.y), texelFetch(weight, q, 0).r);
+    return;
+  }
+
+  // f̉Ae߂
+  fc = dual ? mix(background(texcoord.pq), background(texcoord.st), texelFetch(weight, q, 0).r) : background(texcoord.st);
+}
@@ -7,6 +7,44 @@
 // OpenCV ɂrfILv`
 #include "CamCv.h"
 
+// 摜ɂLv`
+#include "CamSynthetic.h"
+
+// ̃t[̋L^ƍĐ
+#include "CamRaw.h"
+
+// ɉeNX`̃^C̑I
+#include "ViewTiles.h"
+
+// WJ̉fƂ̃eNX`WQƕ\ɋ߂ĕ`
+#include "RemapTable.h"
+
+// ̃J̓Lv`
+#include "CameraGroup.h"
+
+// e̔`ɉēKIɕbV
+#include "AdaptiveMesh.h"
+
+// `摜̔񓯊̓ǂݏoƃt@Cւ̏o
+#include "BatchWriter.h"
+
+// ̃J؂ỏzIȃpE`gEY[̃r[
+#include "MultiView.h"
+
+// WJɎgVF[_ɋʂ̃p[^̃jtH[obt@
+#include "Expansion.h"
+
+// sɐ؂ւWJɎgVF[_̃vÖꗗ
+#include "ShaderLibrary.h"
+
+// VF[_vÕoCĩLbV
+#include "ProgramCache.h"
+
+// Video4Linux2 ɂrfILv`
+#if defined(__linux__)
+#  include "CamV4L2.h"
+#endif
+
 //
 // ݒ
 //
@@ -16,10 +54,59 @@
 //#define CAPTURE_INPUT "sp360.mp4"     // Kodak SP360 4K  Fish Eye 摜
 #define CAPTURE_INPUT "theta.mp4"     // THETA S  Equirectangular 摜
 
+// Video4Linux2 Œړ͂foCX (Linux ̂݁A` CAPTURE_INPUT ̑Ɏg)
+//#define CAPTURE_V4L2 "/dev/video0"
+
+// `΃foCX̑ɐ YUYV / NV12 ̃t[ׂt@C CamV4L2 ōĐ
+//   foCXƓobt@҂sɏoꂷ̂ŁA@ȂĂ CAPTURE_V4L2 ̌oHB
+//   𑜓xƉf̌` shader_selection ɁAt[[g capture_fps (0 Ȃ 30) ɏ]B
+//#define CAPTURE_REPLAY "capture.yuyv"
+
+// ` rig_mount ̃YƂɈ䂸̃J CamV4L2 œ͂A𑵂t[̑g
+// eNX`z̃C[ɓ]ĂȂ (CameraGroup.hALinux ̂)
+//   Y̏ɃfoCXt@C (CAPTURE_REPLAY `΍Đt@C) ׁA
+//   CAPTURE_V4L2  CAPTURE_REPLAY ̒l̑ɎgBrender_rig  2 ɂēë̃r[ɎgA
+//   rig_mount  circle ͂ꂼ̃J̃t[ɎʂC[WT[NɂB
+//#define CAPTURE_GROUP { "/dev/video0", "/dev/video2" }
+
+// CAPTURE_GROUP œgƂ݂Ȃt[̎̍̋e͈ (b)
+constexpr double group_tolerance(0.005);
+
+// CAPTURE_GROUP Ŏ̂҂ăt[̑g̓]񐔂̏
+constexpr unsigned int group_hold(3);
+
+// CAPTURE_INPUT ̃t@C^lbg[N FFmpeg ŃfR[h (`Ȃ OpenCV g)
+//   CAPTURE_INPUT ɂ̓t@C URL w肷 (Lv`foCX̔ԍ͎gȂ)B
+//   Linux ł make FFMPEG=1 Œ`Alibavformat / libavcodec / libavutil NB
+//#define CAPTURE_FFMPEG
+
+// FFmpeg ŃfR[hɎgXbh̐ (0 Ȃ玩)
+constexpr int capture_threads(0);
+
+// `Γ͂̑ shader_selection ̃YŎBeZp̊iq
+//   l̓t[[gŁA0 Ȃ`悪󂯎邽тɎ̃t[n (x`}[Np)
+//#define CAPTURE_SYNTHETIC 30.0
+
+// `Γ͂̑ CAPTURE_RECORD ŋL^t@CfR[hɍĐ
+//#define CAPTURE_RAW "capture.raw"
+
+// CAPTURE_RAW L^ɍ킹čĐ (false Ȃ`悪󂯎邽тɎ̃t[n)
+constexpr bool capture_paced(true);
+
+// `΃Lv`t[̂܂܃t@CɋL^
+//   t[ǂݏô capture_transfer  Camera::STAGING_BUFFER ͎gȂB
+//#define CAPTURE_RECORD "capture.raw"
+
 // wi摜WJ@ (ExpansionShader.h Q)
 //constexpr int shader_selection(6);    // Kodak SP360 4K
 //constexpr int shader_selection(7);    // THETA S  Dual Fisheye 摜
 constexpr int shader_selection(2);    // THETA S  Equirectangular 摜
+//constexpr int shader_selection(9);    // THETA S  HDMI o͂ YUYV ̂܂ܓ (CAPTURE_V4L2  CAPTURE_REPLAY Kv)
+
+// sɐL[ (EBhEJȂƂ Window::setSelection())  shader_type[] ̓WJ̎@؂ւ
+//   ׂĂ̎@̃vONɍn߂Ă̂ŁA؂ւ̓vOłĂ glUseProgram() ōςށB
+//   J̉𑜓xƉf̌` shader_selection ̂܂ܕςAC[WT[N̐؂oƃO͎gȂB
+constexpr bool shader_switching(false);
 
 // wi摜̓WJɎgpo[ebNXVF[_̃\[Xt@C
 const char *const capture_vsrc(shader_type[shader_selection].vsrc);
@@ -27,6 +114,9 @@ const char *const capture_vsrc(shader_type[shader_selection].vsrc);
 // wi摜̓WJɎgptOgVF[_̃\[Xt@C
 const char *const capture_fsrc(shader_type[shader_selection].fsrc);
 
+// wi摜̉f̌`
+constexpr CaptureColor capture_color(shader_type[shader_selection].color);
+
 // wi摜̎擾ɎgpJ̉𑜓x (0 ȂJ擾)
 const int capture_width(shader_type[shader_selection].width);
 const int capture_height(shader_type[shader_selection].height);
@@ -34,14 +124,121 @@ const int capture_height(shader_type[shader_selection].height);
 // wi摜̎擾ɎgpJ̃t[[g (0 ȂJ擾)
 constexpr int capture_fps(0);
 
+// wi摜̃eNX`ւ̓]@
+//   Camera::CLIENT_MEMORY  NCAg̃璼ړ]
+//   Camera::PIXEL_BUFFER   sNZobt@IuWFNg̃OɕʂĂ]
+//   Camera::STAGING_BUFFER iIɃ}bvXe[WOobt@ɒڃLv`ē]
+constexpr Camera::Transfer capture_transfer(Camera::CLIENT_MEMORY);
+
+// [r[t@Cǂ݂t[ (0 Ȃǂ݂Ȃ)
+constexpr int capture_ahead(0);
+
 // wi摜̊֐S̈
 const float *const capture_circle(shader_type[shader_selection].circle);
 
+// fisheye.vert œWJƂ̓C[WT[NɊOڂ͈͂eNX`ɓ]
+constexpr bool capture_crop(false);
+
+// eNX`̉f̃^CɕĎQƂ^C] (0 Ȃt[Ŝ])
+constexpr int capture_tile(0);
+
+// QƂ^C߂Ƃɗ]Ɋ܂߂fƎ\t[
+constexpr int tile_margin(2);
+constexpr int tile_ahead(2);
+
+// wi摜̃eNX`ꖇ̑傫̏ (0 ȂhCo GL_MAX_TEXTURE_SIZEA番)
+constexpr int texture_limit(0);
+
 // wi摜̕`ɗp郁bV̊iq_
 constexpr int screen_samples(1271);
 
-// wiF͕\Ȃ 0 ɂĂKv
-constexpr GLfloat background[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+// wi摜̃bV𓊉e̔`ɉĕƂ̋e덷 (XN[̉fA0 ȂŒ̊iq)
+constexpr double mesh_tolerance(0.0);
+
+// wi摜̃bV̊{̊iq𕪊ő̉
+constexpr int mesh_levels(5);
+
+// HEADLESS `ărhƂɕ`t[obt@IuWFNg̑傫
+//   EBhEJ EGL ŕ`̂ŁAfBXvĈȂT[o GPU ̂Ȃ CI ł
+//   (Mesa ̃\tgEFA_O) BMakefile ł make HEADLESS=1 ŃrhB
+constexpr int headless_width(1920);
+constexpr int headless_height(1080);
+
+// HEADLESS `ărhƂɕ`t[ (0 Ȃ SIGINT  SIGTERM 󂯎܂ŕ`)
+constexpr unsigned long headless_frames(300);
+
+// HEADLESS `ărhƂɍŌɕ`摜ۑ TGA t@C (nullptr ȂۑȂ)
+const char *const headless_snapshot("headless.tga");
+
+// `ΈꊇϊƂāAׂ͂̂Ẵt[ɍ킹ɏɓWJĘAԂ TGA t@Cɏo
+//   l̓t@C̏ŁAt[̔ԍ𖄂ߍށB[r[t@CL^t@C͍Ō̃t[ŏIB
+//   HEADLESS `ărh΃EBhEJɕϊłB
+//#define BATCH_OUTPUT "frame%06lu.tga"
+
+// ꊇϊœǂݏoɎgsNZobt@IuWFNg̐Əo[JXbh̐ (0 Ȃn[hEFÃXbh̔)
+constexpr int batch_buffers(4);
+constexpr int batch_threads(0);
+
+// ꊇϊŏoő̃t[ (0 Ȃ͂̍Ō܂)
+constexpr unsigned long batch_frames(0);
+
+// Vt[͂Y[ȂǂςĂȂΕ`ɃCxg҂
+//   false Ȃ疈`ăJ[obt@ւB
+constexpr bool render_idle(false);
+
+// `ȂƂɃCxg҂Œ̎ (b)
+constexpr double idle_timeout(0.5);
+
+// OƓẽt[ (ꎞ~Xg[Ȃ) ͕`ɓnȂ
+//   t[ǂݏoĔׂ̂ŁAcapture_transfer  Camera::STAGING_BUFFER ̂Ƃ͎gȂB
+constexpr bool capture_skip_repeated(false);
+
+// WJ̃p[^ςƂfƂ̃eNX`WQƕ\ɋ߂ĂAgĕ`
+//   false Ȃ烁bV̒_Ŗt[eNX`W߂ĕ`B
+constexpr bool render_lookup(false);
+
+// wi摜𕡐̃Y̑ȂBeu (O) ƂēWJ (Rig.h)
+//   0: gȂ
+//   1: theta.vert ƓO̋჌Y (C[WT[N̒f)
+//   2: rig_mount ̕\̃Y
+//   fƂɎg̃YƍQƕ\ɋ߂Ă̂ŁArender_lookup ɂ炸Qƕ\ŕ`B
+//   ë̃r[ɂgB
+constexpr int render_rig(0);
+
+// render_rig  2 ̂ƂɂȂY̌Ɣ͈ (ő 8 )
+//   ͐`̃t[ 2~2 ɕׂl 190 ̋჌Y̑𐅕 90 ́B
+constexpr RigMount rig_mount[] =
+{
+  {   0.0f, 0.0f, 0.0f, 190.0f, 10.0f, { 3.316126f, 3.316126f, -0.25f,  0.25f } },
+  {  90.0f, 0.0f, 0.0f, 190.0f, 10.0f, { 3.316126f, 3.316126f,  0.25f,  0.25f } },
+  { 180.0f, 0.0f, 0.0f, 190.0f, 10.0f, { 3.316126f, 3.316126f, -0.25f, -0.25f } },
+  { 270.0f, 0.0f, 0.0f, 190.0f, 10.0f, { 3.316126f, 3.316126f,  0.25f, -0.25f } }
+};
+
+// WJ̓e (ǂ̃Y̓WJł`̂ŁABATCH_OUTPUT  headless_snapshot ŏo)
+//   MultiView::PERSPECTIVE      ̕𓧎e (view_count ̃r[ɕ)
+//   MultiView::CUBEMAP          ̘̂Zʂ 3~2 ɕׂĈ̕`ŕ` (3:2 ̃EBhEŊeʂ`ɂȂ)
+//   MultiView::EQUIRECTANGULAR  S𐳋~}@ŕ` (2:1 ̃EBhEŏc̊px̔䂪)
+//   PERSPECTIVE ȊOł͎Qƕ\KIɕbV͎g킸AzC[ɂY[͌ȂB
+constexpr MultiView::Projection output_projection(MultiView::PERSPECTIVE);
+
+// xɕ`zIȃpE`gEY[̃r[̐ (1 ȂEBhEŜɈ̃r[`Aő 16)
+//   EBhEiqɋ؂ApSɓԊuɂ炵r[̃CX^X`łׂĕ`B
+//   ̉]ƃY[ׂ̑͂Ẵr[ɋʂɂAQƕ\KIɕbV͎gȂB
+constexpr int view_count(1);
+
+// ̃r[`Ƃ̃`g (xA჌Ył͌̌XAS̉摜ł͐̋p)
+constexpr GLfloat view_tilt(0.0f);
+
+// NVF[_vÕoCiۑt@C̑Oɕt镶 (nullptr ȂRpC)
+//   \[Xt@C̑gƂɈ̃t@CɕۑA\[XvO OpenGL ̃hCoςΏB
+//   Ⴆ "program_" ɂ program_fisheye.vert_normal.frag.bin ̂悤ȃt@CɂȂB
+const char *const program_cache(nullptr);
+
+// FFmpeg ɂrfILv`
+#if defined(CAPTURE_FFMPEG)
+#  include "CamFFmpeg.h"
+#endif
 
 //
 // C
@@ -49,28 +246,158 @@ constexpr GLfloat background[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
 int main()
 {
-  // J̎gpJn
-  CamCv camera;
-  if (!camera.open(CAPTURE_INPUT, capture_width, capture_height, capture_fps))
+#if defined(HEADLESS)
+  // EBhEJɃt[obt@IuWFNgɕ`
+  Window window("fisheye", headless_width, headless_height);
+
+  // t[obt@IuWFNgꂽǂm߂
+  if (!window.isValid())
   {
-    std::cerr << "Can't open capture device.\n";
+    // EGL ̃ReLXgt[obt@IuWFNgȂ
+    std::cerr << "Can't create a headless EGL context with a " << headless_width << "x" << headless_height << " framebuffer.\n";
     return EXIT_FAILURE;
   }
-  camera.start();
-
+#else
   // EBhE쐬
   Window window;
 
   // EBhEJǂm߂
-  if (!window.get())
+  if (!window.isValid())
   {
     // EBhEJȂ
     std::cerr << "Can't open GLFW window.\n";
     return EXIT_FAILURE;
   }
+#endif
+
+#if defined(CAPTURE_RECORD)
+  // Lv`t[L^郌R[_ (J̃Xbhɔj悤ɐɍ)
+  RawRecorder recorder;
+#endif
+
+  // 𑵂ē͂J̃O[v (CAPTURE_GROUP `Ȃ΋)
+  CameraGroup group(group_tolerance, group_hold);
+
+  // J̎gpJn
+  //   Xe[WOobt@̓t[̃ƂĎĝ
+  //   OpenGL ̃ReLXg쐬ĂJJB
+#if defined(CAPTURE_GROUP)
+  // rig_mount ̃Y̏ɃJJăO[vɉ
+  //   ŏ̃J\ɂāAق̃JɂݒAv͂̃Ĵ̂\B
+  static_assert(render_rig == 2, "CAPTURE_GROUP needs render_rig 2.");
+#  if defined(BATCH_OUTPUT)
+#    error "CAPTURE_GROUP can't be used with BATCH_OUTPUT."
+#  endif
+  const char *const group_input[] = CAPTURE_GROUP;
+  static_assert(std::extent<decltype(group_input)>::value == std::extent<decltype(rig_mount)>::value,
+    "CAPTURE_GROUP needs one camera for each rig_mount lens.");
+  bool opened(true);
+  for (const char *const input : group_input)
+  {
+    CamV4L2 *const member(new CamV4L2);
+    group.add(member);
+    member->setTransfer(capture_transfer);
+#  if defined(CAPTURE_REPLAY)
+    static_assert(capture_color != CAPTURE_BGR, "CAPTURE_REPLAY needs YUYV or NV12 frames.");
+    opened = opened && member->replay(input, capture_color == CAPTURE_YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12,
+      capture_width, capture_height, capture_fps);
+#  else
+    opened = opened && member->open(input, capture_color == CAPTURE_YUYV ? V4L2_PIX_FMT_YUYV
+      : capture_color == CAPTURE_NV12 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_MJPEG,
+      capture_width, capture_height, capture_fps);
+#  endif
+  }
+  Camera &camera(group[0]);
+  if (!opened)
+#elif defined(CAPTURE_REPLAY)
+  // t@C YUYV  NV12 ̃t[foCX̃obt@Ɠ悤ɓ͂
+  static_assert(capture_color != CAPTURE_BGR, "CAPTURE_REPLAY needs YUYV or NV12 frames.");
+  CamV4L2 camera;
+  camera.setTransfer(capture_transfer);
+  if (!camera.replay(CAPTURE_REPLAY, capture_color == CAPTURE_YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12,
+    capture_width, capture_height, capture_fps))
+#elif defined(CAPTURE_V4L2)
+  // YUYV  NV12 ͂̂܂ܓ͂ABGR Ȃ MJPEG WJ
+  CamV4L2 camera;
+  camera.setTransfer(capture_transfer);
+  if (!camera.open(CAPTURE_V4L2, capture_color == CAPTURE_YUYV ? V4L2_PIX_FMT_YUYV
+    : capture_color == CAPTURE_NV12 ? V4L2_PIX_FMT_NV12 : V4L2_PIX_FMT_MJPEG,
+    capture_width, capture_height, capture_fps))
+#elif defined(CAPTURE_FFMPEG)
+  // BGR ɕϊɃfR[hftH[}bĝ܂ܓ͂
+  CamFFmpeg camera;
+  camera.setTransfer(capture_transfer);
+  camera.setThreads(capture_threads);
+  if (!camera.open(CAPTURE_INPUT))
+#elif defined(CAPTURE_RAW)
+  // L^Ƃ̉f̌`̂܂܍Đ
+  CamRaw camera;
+  camera.setTransfer(capture_transfer);
+  if (!camera.open(CAPTURE_RAW, capture_paced))
+#elif defined(CAPTURE_SYNTHETIC)
+  // ʓWJ̐ݒ̉𑜓xƉf̌`ō
+  CamSynthetic camera;
+  camera.setTransfer(capture_transfer);
+  if (!camera.open(shader_type[shader_selection], CAPTURE_SYNTHETIC, capture_width, capture_height))
+#else
+  // OpenCV ł BGR ɕϊt[Ȃ
+  static_assert(capture_color == CAPTURE_BGR, "YUYV and NV12 capture needs CAPTURE_V4L2, CAPTURE_REPLAY, CAPTURE_RAW or CAPTURE_SYNTHETIC.");
+  CamCv camera;
+  camera.setTransfer(capture_transfer);
+  camera.setAhead(capture_ahead);
+  if (!camera.open(CAPTURE_INPUT, capture_width, capture_height, capture_fps))
+#endif
+  {
+    std::cerr << "Can't open capture device.\n";
+    return EXIT_FAILURE;
+  }
+#if defined(CAPTURE_RECORD)
+  if (!recorder.open(CAPTURE_RECORD, camera))
+  {
+    // L^t@CJȂ
+    std::cerr << "Can't open record file.\n";
+    return EXIT_FAILURE;
+  }
+  if (!camera.setRecorder(&recorder))
+  {
+    // ݐp̃Xe[WOobt@ɒut[͋L^łȂ
+    std::cerr << "Can't record frames from the staging buffer, use another capture_transfer.\n";
+    return EXIT_FAILURE;
+  }
+#endif
+
+  // C[WT[N̊O̍]Ȃ悤ɂ
+  //   Oł͕̃Y̑gAWJ̎@؂ւƂ͕ʂ̃C[WT[NɂȂ̂Ő؂oȂB
+  if (capture_crop && render_rig == 0 && !shader_switching && strcmp(capture_vsrc, "fisheye.vert") == 0) camera.cropCircle(capture_circle);
+
+  // QƂ^C]
+  camera.setTileSize(capture_tile);
+  ViewTiles tiles(capture_vsrc, tile_margin, tile_ahead);
+
+#if defined(BATCH_OUTPUT)
+  // ꊇϊłׂ͂Ẵt[Ɏ󂯎
+  camera.setBatch(true);
+#endif
+
+  // Vt[nCxg҂NĂ炢Aẽt[͓nȂ悤ɂ
+  //   ꊇϊł͓ẽt[ôŊԈȂB
+  camera.setWakeup(render_idle || camera.isBatch());
+  camera.setSkipRepeated(capture_skip_repeated && !camera.isBatch());
+  for (int i = 1; i < group.size(); ++i)
+  {
+    group[i].setWakeup(render_idle);
+    group[i].setSkipRepeated(capture_skip_repeated);
+  }
+
+  if (group.size() > 0) group.start(); else camera.start();
 
   // wi`p̃VF[_vOǂݍ
-  const GLuint expansion(ggLoadShader(capture_vsrc, capture_fsrc));
+  //   ȑOɓ\[XvOƃhCoŃNoCi΃RpCȂB
+  //   ؂ւɎgق̓WJ̎@̃vO͕`~߂ɍB
+  ProgramCache::setPrefix(program_cache);
+  ShaderLibrary library(window, shader_type, static_cast<int>(std::extent<decltype(shader_type)>::value),
+    shader_selection, shader_switching && render_rig == 0);
+  GLuint expansion(library.getProgram(shader_selection));
   if (!expansion)
   {
     // VF[_ǂݍ߂Ȃ
@@ -79,29 +406,105 @@ int main()
   }
 
   // uniform ϐ̏ꏊw肷
-  const GLuint gapLoc(glGetUniformLocation(expansion, "gap"));
-  const GLuint screenLoc(glGetUniformLocation(expansion, "screen"));
-  const GLuint focalLoc(glGetUniformLocation(expansion, "focal"));
-  const GLuint rotationLoc(glGetUniformLocation(expansion, "rotation"));
-  const GLuint circleLoc(glGetUniformLocation(expansion, "circle"));
-  const GLuint imageLoc(glGetUniformLocation(expansion, "image"));
+  //   WJ̃p[^ Expansion ubNɂ܂Ƃ߂ăjtH[obt@nB
+  GLuint yuvLoc(glGetUniformLocation(expansion, "yuv"));
+
+  // WJ̃p[^i[郆jtH[obt@WJɎgVF[_Ɍ
+  ExpansionBuffer parameter;
+  parameter.bind(expansion);
 
   // wip̃eNX`쐬
   //   |SŃr[|[gŜ𖄂߂̂Ŕwi͕\ȂB
-  //   GL_CLAMP_TO_BORDER ɂĂ΃eNX`̊O GL_TEXTURE_BORDER_COLOR ɂȂ̂ŁAꂪwiFɂȂB
-  const GLuint image([]() { GLuint image; glGenTextures(1, &image); return image; } ());
-  glBindTexture(GL_TEXTURE_2D, image);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, camera.getWidth(), camera.getHeight(), 0, GL_BGR, GL_UNSIGNED_BYTE, NULL);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, background);
+  //   YUYV  (Y, U), (Y, V) ̑g GL_RG8 ɁANV12 ͋Px GL_R8 ɁA
+  //   Fc̉𑜓x GL_RG8 Ɋi[ăVF[_ RGB ɕϊB
+  //   őTCY𒴂Ƃ͕ăeNX`zɊi[AVF[_͂ȂŃTvOB
+  //   C[WT[N؂oƂ̓eNX`̊O܂ԂɍɂB
+  //   J̃O[v͂ꂼ̃J̃t[O[ṽeNX`z̃C[Ɋi[B
+  SourceTexture texture;
+  if (group.size() > 0 ? !group.createTexture() : !texture.create(camera.getCropWidth(), camera.getCropHeight(),
+    camera.getFormat(), camera.hasChroma(), texture_limit,
+    camera.getCropWidth() < camera.getWidth() || camera.getCropHeight() < camera.getHeight()))
+  {
+    // ĂeNX`zɎ܂ȂAO[ṽJ̉摜̃TCYtH[}bgĂȂ
+    std::cerr << "Can't create a texture for " << camera.getCropWidth() << "x" << camera.getCropHeight() << " frames.\n";
+    return EXIT_FAILURE;
+  }
+  if (group.size() == 0) camera.setTexture(&texture);
+
+  // eNX`jbgƃeNX`̕w肷
+  //   uniform ϐ̒l̓vOێ̂ŁAvO؂ւƂw肵B
+  texture.setUniforms(expansion);
 
   // wi`̂߂̃bV쐬
   //   _Wl vertex shader Ő̂ VBO ͕KvȂ
   const GLuint mesh([]() { GLuint mesh; glGenVertexArrays(1, &mesh); return mesh; } ());
 
+  // ̉zIȃpE`gEY[̃r[̘̂Z
+  //   r[Ƃ̃p[^̓jtH[obt@ɓēWJɎgVF[_ɌĂB
+  //   ~}@͈̃r[ŃEBhEŜɕ`B
+  //   r[łVF[_̓jtH[ubN錾Ă̂ŁAɃobt@ĂB
+  MultiView views(capture_vsrc, output_projection == MultiView::CUBEMAP ? 6
+    : output_projection == MultiView::EQUIRECTANGULAR ? 1 : view_count, view_tilt * 0.01745329f);
+  if (output_projection == MultiView::CUBEMAP) views.setCubemap();
+  const bool multiple(views.getCount() > 1);
+  views.bind(expansion);
+  const bool perspective(output_projection == MultiView::PERSPECTIVE);
+
+  // fƂ̃eNX`W̎Qƕ\IuWFNg
+  RemapTable remap(capture_vsrc);
+
+  // ÕYw肷΁AfƂɎg̃YƍQƕ\ɋ߂ĕ`
+  std::vector<RigLens> lenses;
+  if (render_rig == 1)
+    lenses = makeDualFisheyeRig(capture_circle, camera.getWidth(), camera.getHeight());
+  else if (render_rig == 2)
+    for (const RigMount &mount : rig_mount) lenses.push_back(makeRigLens(mount, camera.getWidth(), camera.getHeight()));
+  const bool rig(!lenses.empty() && perspective && !multiple && remap.setRig(lenses));
+  bool lookup((render_lookup || rig) && perspective && !multiple && remap.isValid());
+  if (group.size() > 0 && !(rig && lookup))
+  {
+    // J̃O[v̓O̎Qƕ\ł`Ȃ
+    std::cerr << "Can't use CAPTURE_GROUP without a rig lookup table for a single perspective view.\n";
+    return EXIT_FAILURE;
+  }
+
+  // e̔`ɉĕbV
+  //   e덷 0 ȂŒ̊iqŕ`B
+  AdaptiveMesh grid(expansion, capture_vsrc, mesh_tolerance, mesh_levels);
+  bool adaptive(!lookup && perspective && !multiple && grid.isValid());
+
+  // Qƕ\╪bVgƂ͌Œ̊iq萳mɃeNX`W܂̂ŁA
+  // QƂ^CׂiqŒׂ
+  if (lookup || adaptive) tiles.setSubdivision(2);
+
+  // wi̕`ɗv GPU ̎ԂvNG
+  //   ʂ҂Ȃ悤ɓ݂ɎgAt[ǑʂώZB
+  //   ŏ̃t[̓VF[_̏Ȃǂ܂݁Allvmpipe ł͌O̒lԂ̂ŐώZȂB
+  const std::array<GLuint, 2> timer([]() { std::array<GLuint, 2> timer; glGenQueries(2, timer.data()); return timer; } ());
+  unsigned long drawn(0), timed(0);
+  double drawTime(0.0);
+
+  // O`Ƃ̓WJ̃p[^ƕ`Ȃ
+  std::vector<GLfloat> drawnKey;
+  unsigned long skipped(0);
+
+  // gĂWJ̎@̔ԍƐ؂ւ
+  int selection(shader_selection);
+  unsigned long switched(0);
+  window.setSelection(shader_selection);
+
+#if defined(BATCH_OUTPUT)
+  // `摜ǂݏoďosNZobt@IuWFNg̃Oƃ[JXbh
+  BatchWriter writer(BATCH_OUTPUT, window.getWidth(), window.getHeight(), batch_buffers, batch_threads);
+
+  // ꊇϊł͐҂Ȃ
+  window.setSwapInterval(0);
+
+  // ꊇϊJnƕ`Xbh]ǂݏo̔s܂łɗvԂ̍v
+  const std::chrono::steady_clock::time_point batchStart(std::chrono::steady_clock::now());
+  double renderTime(0.0);
+#endif
+
   // Bʏݒ肷
   glDisable(GL_DEPTH_TEST);
   glDisable(GL_CULL_FACE);
@@ -109,6 +512,40 @@ int main()
   // EBhEJĂԌJԂ
   while (!window.shouldClose())
   {
+#if defined(BATCH_OUTPUT)
+    // ̃t[̏Jn
+    const std::chrono::steady_clock::time_point iteration(std::chrono::steady_clock::now());
+#endif
+
+    // ʂ̓WJ̎@I΂ĂāÃvOłĂΐ؂ւ
+    //   ܂łĂȂ΍̎@̂܂ܕ`B
+    library.update();
+    if (shader_switching && render_rig == 0 && window.getSelection() != selection)
+    {
+      const GLuint program(library.getProgram(window.getSelection()));
+      if (program)
+      {
+        // vO؂ւăjtH[ubNƃeNX` uniform ϐݒ肷
+        selection = window.getSelection();
+        expansion = program;
+        yuvLoc = glGetUniformLocation(expansion, "yuv");
+        parameter.bind(expansion);
+        views.bind(expansion);
+        texture.setUniforms(expansion);
+
+        // ẽfɈˑ̂؂ւ
+        const char *const vsrc(shader_type[selection].vsrc);
+        tiles.setModel(vsrc);
+        views.setModel(vsrc);
+        remap.setModel(vsrc);
+        grid.setModel(expansion, vsrc);
+        lookup = render_lookup && perspective && !multiple && remap.isValid();
+        adaptive = !lookup && perspective && !multiple && grid.isValid();
+        tiles.setSubdivision(lookup || adaptive ? 2 : 1);
+        ++switched;
+      }
+    }
+
     // wi摜̓WJɗpVF[_vO̎gpJn
     glUseProgram(expansion);
 
@@ -116,13 +553,17 @@ int main()
     //   W{_̐ (_) n = x * y ƂƂAɃAXyNg a = x / y ΁A
     //   a * n = x * x ƂȂ邩 x = sqrt(a * n), y = n / x; ŋ߂B
     //   ̕@͒_ĂȂ̂ŎsɕW{_̐AXyNg̕ύXeՁB
-    const GLsizei slices(static_cast<GLsizei>(sqrt(window.getAspect() * screen_samples)));
-    const GLsizei stacks(screen_samples / slices - 1); // `悷CX^X̐Ȃ̂Ő 1 ĂB
+    //   ̃r[`Ƃ͕W{_r[̐ŕāA̃r[̋`̃AXyNgŋ߂B
+    const GLfloat aspect(multiple ? views.getAspect(window.getAspect()) : window.getAspect());
+    const GLsizei samples(screen_samples / views.getCount());
+    const GLsizei slices(static_cast<GLsizei>(sqrt(aspect * samples)));
+    const GLsizei stacks(samples / slices - 1); // ̃r[`CX^X̐Ȃ̂Ő 1 ĂB
 
     // XN[̊iqԊu
     //   NbsOԑŜ𖄂߂lp` [-1, 1] ͈̔͂Ȃ킿c 2 ̑傫A
     //   c (iq - 1) ŊĊiq̊Ԋu߂B
-    glUniform2f(gapLoc, 2.0f / (slices - 1), 2.0f / stacks);
+    parameter->gap[0] = 2.0f / (slices - 1);
+    parameter->gap[1] = 2.0f / stacks;
 
     // XN[̃TCYƒSʒu
     //   screen[0] = (right - left) / 2
@@ -130,16 +571,19 @@ int main()
     //   screen[2] = (right + left) / 2
     //   screen[3] = (top + bottom) / 2
     const GLfloat screen[] = { window.getAspect(), 1.0f, 0.0f, 0.0f };
-    glUniform4fv(screenLoc, 1, screen);
+    ExpansionBuffer::set(parameter->screen, screen, 4);
 
     // XN[܂ł̏œ_
     //   window.getWheel()  [-100, 49] ͈̔͂ԂB
     //   ďœ_ focal  [1 / 3, 1] ͈̔͂ɂȂB
     //   ͏œ_Ȃɂĕω傫ȂB
-    glUniform1f(focalLoc, -50.0f / (window.getWheel() - 50.0f));
+    const GLfloat focal(-50.0f / (window.getWheel() - 50.0f));
+    parameter->focal = focal;
 
     // wiɑ΂鎋̉]s
-    glUniformMatrix4fv(rotationLoc, 1, GL_TRUE, window.getLeftTrackball().get());
+    const GgMatrix rotation(window.getLeftTrackball());
+    //   VF[_ row_major Ŏ󂯎̂ŁAD̔ẑ܂܊i[Γ]uēnƂɂȂB
+    ExpansionBuffer::set(parameter->rotation, rotation.get(), 16);
 
     // eNX`̔aƒSʒu
     //   circle[0] = C[WT[N x ̔a
@@ -148,26 +592,228 @@ int main()
     //   circle[3] = C[WT[N̒S y W
     const GLfloat circle[] =
     {
-      capture_circle[0] + window.getShiftWheel() * 0.001f,
-      capture_circle[1] + window.getShiftWheel() * 0.001f,
-      capture_circle[2] + (window.getShiftArrowX() - window.getControlArrowX()) * 0.001f,
-      capture_circle[3] + (window.getShiftArrowY() + window.getControlArrowY()) * 0.001f
+      shader_type[selection].circle[0] + window.getShiftWheel() * 0.001f,
+      shader_type[selection].circle[1] + window.getShiftWheel() * 0.001f,
+      shader_type[selection].circle[2] + (window.getShiftArrowX() - window.getControlArrowX()) * 0.001f,
+      shader_type[selection].circle[3] + (window.getShiftArrowY() + window.getControlArrowY()) * 0.001f
     };
-    glUniform4fv(circleLoc, 1, circle);
+    ExpansionBuffer::set(parameter->circle, circle, 4);
 
-    // Lv`摜wip̃eNX`ɓ]
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, image);
-    camera.transmit();
+    // eNX`ɐ؂ot[͈̔
+    //   crop[0], crop[1] = ؂o͈͂̍̈ʒu / t[̑傫
+    //   crop[2], crop[3] = ؂o͈͂̑傫 / t[̑傫
+    const GLfloat crop[] =
+    {
+      static_cast<GLfloat>(camera.getCropX()) / camera.getWidth(),
+      static_cast<GLfloat>(camera.getCropY()) / camera.getHeight(),
+      static_cast<GLfloat>(camera.getCropWidth()) / camera.getWidth(),
+      static_cast<GLfloat>(camera.getCropHeight()) / camera.getHeight()
+    };
+    ExpansionBuffer::set(parameter->crop, crop, 4);
 
-    // eNX`jbgw肷
-    glUniform1i(imageLoc, 0);
+    // ̃r[`Ƃ̓r[Ƃ̃p[^߂ăjtH[obt@ɓ]
+    if (multiple) views.update(rotation, focal, window.getAspect());
 
-    // bV`悷
-    glBindVertexArray(mesh);
-    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, slices * 2, stacks);
+    // ݂̎Ɨ\QƂ^C߂
+    //   ~}@ł͑S`A\̃ỸO͓ẽfႤ̂ŁAŏɎw肵Ƃ肷ׂẴ^CgB
+    if (multiple)
+      tiles.update(camera, views.getCount(), views.getRotations(), views.getScreens(), views.getFocals(),
+        circle, slices, stacks);
+    else if (perspective && !(rig && render_rig == 2))
+      tiles.update(camera, rotation.get(), screen, focal, circle, slices, stacks);
+
+    // Lv`摜wip̃eNX`ɓ]
+    //   F̕ʂΐF̃eNX`ɂ]B
+    //   J̃O[v͎̑t[̑gꂼ̃C[ɓ]B
+    texture.bind();
+    const bool arrived(group.size() > 0 ? group.transmit() : camera.transmit());
+
+    // ʂɕ\Ăe߂WJ̃p[^
+    std::vector<GLfloat> key(screen, screen + 4);
+    key.push_back(focal);
+    key.insert(key.end(), rotation.get(), rotation.get() + 16);
+    key.insert(key.end(), circle, circle + 4);
+    key.insert(key.end(), crop, crop + 4);
+    key.push_back(static_cast<GLfloat>(selection));
+
+#if defined(BATCH_OUTPUT)
+    // ꊇϊł͐Vt[͂Ƃ`ďoA͂̍Ō܂Ŏ󂯎I
+    if (!arrived)
+    {
+      if (camera.isFinished()) break;
+      window.waitEvents(idle_timeout);
+      continue;
+    }
+#endif
+
+    // Vt[͂Ap[^ς炸AEBhE̓eĂȂ
+    if (render_idle && !arrived && !window.isDamaged() && key == drawnKey)
+    {
+      // `ɐVt[Cxg҂
+      ++skipped;
+      window.waitEvents(idle_timeout);
+      continue;
+    }
+    drawnKey.swap(key);
+
+    // wi摜̉f̌`w肷 (0: BGR, 1: YUYV, 2: PxƐF̕)
+    const GLint yuv(camera.hasChroma() ? 2 : camera.getFormat() == GL_RG ? 1 : 0);
+    glUniform1i(yuvLoc, yuv);
+
+    // t[O̕`ɗvԂώZČvJn
+    const GLuint query(timer[drawn & 1]);
+    if (drawn >= 3)
+    {
+      GLuint64 elapsed;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+      drawTime += static_cast<double>(elapsed) * 1.0e-9;
+      ++timed;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+
+    if (lookup)
+    {
+      // theta.vert ƓOȂC[WT[N̒Y̐ݒɔf
+      if (rig && render_rig == 1) remap.setRig(makeDualFisheyeRig(circle, camera.getWidth(), camera.getHeight()));
+
+      // p[^ςĂQƕ\蒼āAgĕ`悷
+      remap.update(screen, focal, rotation.get(), circle, crop, texture.getWidth(), texture.getHeight());
+      remap.draw(texture, yuv, group.size() > 0 ? &group : nullptr);
+    }
+    else if (adaptive)
+    {
+      // p[^ςĂ烁bV𕪊āA_obt@`悷
+      //   KIɕbV͈̃r[𓧎eŕ`B
+      parameter->adaptive = GL_TRUE;
+      parameter->views = 0;
+      parameter->projection = 0;
+      parameter.send();
+      grid.update(screen, focal, rotation.get(), circle, ViewTiles::getExtent(camera));
+      grid.draw();
+    }
+    else
+    {
+      // bV`悷
+      //   ̃r[`Ƃ̓r[̐CX^X𑝂₵Ĉxɕ`B
+      //   WJ̃p[^͂ňxɃjtH[obt@ɓ]B
+      parameter->adaptive = GL_FALSE;
+      parameter->views = multiple ? views.getCount() : 0;
+      parameter->instances = stacks;
+      parameter->projection = output_projection == MultiView::EQUIRECTANGULAR;
+      parameter.send();
+      glBindVertexArray(mesh);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, slices * 2, stacks * views.getCount());
+    }
+
+    // vI
+    glEndQuery(GL_TIME_ELAPSED);
+    ++drawn;
+
+#if defined(BATCH_OUTPUT)
+    // `摜񓯊ɓǂݏoă[JXbhɏo
+    writer.capture(0, 0, window.getWidth(), window.getHeight());
+    renderTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - iteration).count();
+
+    // w肵t[oI
+    if (batch_frames > 0 && writer.getFrames() >= batch_frames) break;
+#endif
 
     // J[obt@ւăCxgo
     window.swapBuffers();
+
+#if defined(HEADLESS)
+    // w肵t[`I
+    if (headless_frames > 0 && drawn >= headless_frames) break;
+#endif
+  }
+
+#if defined(HEADLESS)
+  // Ōɕ`摜ۑ
+  if (headless_snapshot && drawn > 0 && !ggSaveColor(headless_snapshot))
+    std::cerr << "Can't save the snapshot to " << headless_snapshot << ".\n";
+#endif
+
+  // WJ̎@؂ւƂ̓vO@Ɛ؂ւ񐔂\
+  if (shader_switching) std::cerr << "Expansion programs: " << library.getReady() << " of " << library.getPrograms() << " ready ("
+    << (library.getMethod() == ShaderLibrary::PARALLEL ? "parallel compile"
+      : library.getMethod() == ShaderLibrary::THREAD ? "shared context thread" : "compiled on demand")
+    << "), switched " << switched << " times\n";
+
+  // VF[_vO̍쐬ɗvԂ\
+  std::cerr << "Shader programs: " << ProgramCache::getRestored() << " restored from cache, "
+    << ProgramCache::getCompiled() << " compiled, total time " << ProgramCache::getTime() * 1000.0 << " ms\n";
+
+  // `Ɏgꂸɏ㏑ꂽt[̐\
+  std::cerr << "Captured frames: " << camera.getCaptured()
+    << ", overwritten before transmission: " << camera.getOverwritten() << "\n";
+
+  // t[Lv`Ă`Ɏg܂ł̎Ԃ\
+  std::cerr << "Capture to acquisition latency: average " << camera.getLatency() * 1000.0
+    << " ms, maximum " << camera.getMaxLatency() * 1000.0 << " ms\n";
+
+  // eNX`ւ̓]ɗvԂ\
+  std::cerr << "Transmitted frames: " << camera.getTransmitted()
+    << (camera.getTransfer() == Camera::STAGING_BUFFER ? " (staging buffer)"
+      : camera.getTransfer() == Camera::PIXEL_BUFFER ? " (pixel buffer)" : " (client memory)")
+    << ", average time: " << camera.getTransmitTime() * 1000.0 << " ms"
+    << ", bytes per frame: " << camera.getTransmitBytes() << " of " << camera.getUploadSize() << "\n";
+
+  // wi̕`ɗv GPU ̎Ԃ\
+  std::cerr << "Background rendering: average GPU time " << (timed > 0 ? drawTime * 1000.0 / timed : 0.0) << " ms"
+    << (rig ? " (rig lookup table, " + std::to_string(remap.getLenses()) + " lenses, rebuilt " + std::to_string(remap.getBaked()) + " times)"
+      : lookup ? " (lookup table, rebuilt " + std::to_string(remap.getBaked()) + " times)"
+      : adaptive ? " (adaptive mesh, " + std::to_string(grid.getVertexCount()) + " vertices, rebuilt " + std::to_string(grid.getBuilt()) + " times)"
+      : " (instanced mesh, " + std::to_string(screen_samples) + " vertices"
+        + (multiple ? ", " + std::to_string(views.getCount()) + " views" : "") + ")") << "\n";
+
+  // J̃O[vȂ]t[̑ĝĂ̂̐ƁAJƂ̎̂\
+  if (group.size() > 0)
+  {
+    std::cerr << "Camera group: " << group.getTransmitted() << " frame sets transmitted, "
+      << group.getMatched() << " within " << group_tolerance * 1000.0 << " ms\n";
+    for (int i = 0; i < group.size(); ++i)
+      std::cerr << "  camera " << i << ": captured " << group[i].getCaptured() << ", transmitted " << group[i].getTransmitted()
+        << ", dropped while held " << group.getDropped(i) << ", late in " << group.getMismatched(i)
+        << " sets, drift average " << group.getDrift(i) * 1000.0 << " ms, maximum " << group.getMaxDrift(i) * 1000.0 << " ms\n";
   }
+
+#if defined(BATCH_OUTPUT)
+  // c̃t[oāAŜƒiƂ̏x\
+  //   iƂ̒l͂̒i𓮂Ƃɏo鑬xŁAŜ͂̂łx̂ɗB
+  writer.flush();
+  const double batchTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count());
+  const unsigned long frames(writer.getFrames());
+  const auto fps([](double time) { return time > 0.0 ? 1.0 / time : 0.0; });
+  const double readTime(writer.getReadTime());
+  const double glTime(frames > 0 ? (renderTime - writer.getStallTime()) / frames - readTime : 0.0);
+  std::cerr << "Batch output: " << writer.getWritten() << " frames written (" << writer.getFailed() << " failed) in "
+    << batchTime << " s, " << (batchTime > 0.0 ? frames / batchTime : 0.0) << " fps overall\n"
+    << "  decode:           " << fps(camera.getDecodeTime()) << " fps (capture thread)\n"
+    << "  upload + dewarp:  " << fps(glTime) << " fps (GL thread)\n"
+    << "  readback:         " << fps(readTime) << " fps (GL thread, waiting for fences and copying)\n"
+    << "  encode:           " << fps(writer.getWriteTime() / writer.getThreads()) << " fps ("
+    << writer.getThreads() << " worker threads)\n"
+    << "  GL thread stalled on encoders for " << writer.getStallTime() << " s\n";
+#endif
+
+  // `Ȃ񐔂ƕ`ɓnȂẽt[̐\
+  std::cerr << "Idle iterations without redraw: " << skipped
+    << ", repeated frames not passed to rendering: " << camera.getRepeated() << "\n";
+
+  // fR[hɗvԂ\
+  std::cerr << "Decoded frames: " << camera.getDecoded()
+    << ", average decode time: " << camera.getDecodeTime() * 1000.0 << " ms\n";
+
+#if !defined(CAPTURE_GROUP) && !defined(CAPTURE_V4L2) && !defined(CAPTURE_REPLAY) && !defined(CAPTURE_FFMPEG) && !defined(CAPTURE_RAW) && !defined(CAPTURE_SYNTHETIC)
+  // ǂ݂̑҂s̒Ɛǂ݂ԂɍȂ񐔂\
+  std::cerr << "Decode-ahead queue: average depth " << camera.getQueueDepth()
+    << ", underruns: " << camera.getUnderrun() << "\n";
+#endif
+
+#if defined(CAPTURE_RECORD)
+  // Lv`Xbh~߂ĂL^I
+  camera.stop();
+  recorder.close();
+  std::cerr << "Recorded frames: " << recorder.getCount() << "\n";
+#endif
 }
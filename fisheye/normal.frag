@@ -1,13 +1,8 @@
-#version 150 core
-#extension GL_ARB_explicit_attrib_location : enable
-
 //
 // eNX`ẄʒủfF̂܂܎g
+//   wieNX`TvO֐ background.glsl ɂB
 //
 
-// wieNX`
-uniform sampler2D image;
-
 // eNX`W
 in vec2 texcoord;
 
@@ -17,5 +12,5 @@ layout (location = 0) out vec4 fc;
 void main(void)
 {
   // f̉Ae߂
-  fc = texture(image, texcoord);
+  fc = background(texcoord);
 }
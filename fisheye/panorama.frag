@@ -1,18 +1,41 @@
-#version 150 core
-#extension GL_ARB_explicit_attrib_location : enable
-
 //
 // ~}@̃eNX`TvO
+//   wieNX`TvO֐ background.glsl ɂB
 //
 
-// wieNX`̔aƒSʒu
-uniform vec4 circle;
+// WJɎgVF[_ɋʂ̃p[^ (Expansion.h)
+layout (std140, row_major) uniform Expansion
+{
+  // XN[]ϊs
+  mat4 rotation;
+
+  // XN[̑傫ƒSʒu
+  vec4 screen;
+
+  // wieNX`̔aƒSʒu
+  vec4 circle;
+
+  // wieNX`ɐ؂ot[͈̔ (t[ɑ΂鍶̈ʒuƑ傫)
+  vec4 crop;
+
+  // XN[̊iqԊu
+  vec2 gap;
+
+  // XN[܂ł̏œ_
+  float focal;
+
+  // KIɕbVgǂ
+  bool adaptive;
+
+  // xɕ`r[̐ (0 Ȃ rotation, screen, focal ŃNbsOԑSʂɈ̃r[`)
+  int views;
 
-// wieNX`
-uniform sampler2D image;
+  // ̃r[`CX^X̐ (iq̍s)
+  int instances;
 
-// wieNX`̃TCY
-vec2 size = textureSize(image, 0);
+  // WJ̓e (0: e, 1: ~}@)
+  int projection;
+};
 
 // wieNX`̃eNX`ԏ̃XP[
 vec2 scale = vec2(-0.15915494, -0.31830989) / circle.st;
@@ -37,5 +60,5 @@ void main(void)
   vec2 texcoord = atan(u, v) * scale + center;
 
   // f̉Ae߂
-  fc = texture(image, texcoord);
+  fc = background(texcoord);
 }
@@ -4,21 +4,69 @@
 // ~}@̃pm}摜̕ʓWJ
 //
 
-// XN[̊iqԊu
-uniform vec2 gap;
+// KIɕbV̒_ʒu
+in vec2 point;
 
-// XN[̑傫ƒSʒu
-uniform vec4 screen;
+// WJɎgVF[_ɋʂ̃p[^ (Expansion.h)
+layout (std140, row_major) uniform Expansion
+{
+  // XN[]ϊs
+  mat4 rotation;
+
+  // XN[̑傫ƒSʒu
+  vec4 screen;
+
+  // wieNX`̔aƒSʒu
+  vec4 circle;
+
+  // wieNX`ɐ؂ot[͈̔ (t[ɑ΂鍶̈ʒuƑ傫)
+  vec4 crop;
+
+  // XN[̊iqԊu
+  vec2 gap;
+
+  // XN[܂ł̏œ_
+  float focal;
+
+  // KIɕbVgǂ
+  bool adaptive;
+
+  // xɕ`r[̐ (0 Ȃ rotation, screen, focal ŃNbsOԑSʂɈ̃r[`)
+  int views;
 
-// XN[܂ł̏œ_
-uniform float focal;
+  // ̃r[`CX^X̐ (iq̍s)
+  int instances;
 
-// XN[]ϊs
-uniform mat4 rotation;
+  // WJ̓e (0: e, 1: ~}@)
+  int projection;
+};
+
+// r[Ƃ̎̉]AXN[̑傫ƒSʒuA``̑傫ƒSʒuAœ_
+struct View
+{
+  mat4 rotation;
+  vec4 screen;
+  vec4 tile;
+  float focal;
+};
+
+// r[Ƃ̃p[^ (MultiView.h)
+layout (std140, row_major) uniform Views
+{
+  View view[16];
+};
 
 // xNg
 out vec4 vector;
 
+// ~}@ŕ`Ƃ̃NbsOԏ̓_ɑ΂]O̎
+//    [-1, 1] ox [-, ] ɁAc [-1, 1] ܓx [-/2, /2] Ɋ蓖āAox 0 ܓx 0  -z ɂB
+vec4 longitudeLatitude(vec2 position)
+{
+  vec2 angle = position * vec2(3.14159265, 1.57079633);
+  return vec4(sin(angle.x) * cos(angle.y), sin(angle.y), -cos(angle.x) * cos(angle.y), 0.0);
+}
+
 void main(void)
 {
   // _ʒu
@@ -28,18 +76,26 @@ void main(void)
   //   ̂悤 GL_TRIANGLE_STRIP ̒_WlB
   //   y  gl_InstaceID 𑫂 glDrawArrayInstanced() ̃CX^XƂ y ωB
   //   Ɋiq̊Ԋu gap  1 Ώc [-1, 1] ͈̔͂̓_Q position B
+  //   KIɕbV (AdaptiveMesh.h) ł͒_ point ̂܂܎gB
   int x = gl_VertexID >> 1;
-  int y = gl_InstanceID + 1 - (gl_VertexID & 1);
-  vec2 position = vec2(x, y) * gap - 1.0;
+  int y = (views > 0 ? gl_InstanceID % instances : gl_InstanceID) + 1 - (gl_VertexID & 1);
+  vec2 position = adaptive ? point : vec2(x, y) * gap - 1.0;
+
+  // ̃CX^X`r[
+  //   ̃r[`Ƃ̓CX^X instances r[Ɋ蓖āA
+  //   ̃r[̎̉]XN[A``jtH[obt@oB
+  View current = views > 0 ? view[gl_InstanceID / instances]
+    : View(rotation, screen, vec4(1.0, 1.0, 0.0, 0.0), focal);
 
-  // _ʒû܂܃X^CUɑ΃NbsOԑSʂɕ`
-  gl_Position = vec4(position, 0.0, 1.0);
+  // _ʒur[̋`ɍ킹ăX^CUɑ (̃r[ȂNbsOԑSʂɕ`)
+  gl_Position = vec4(position * current.tile.st + current.tile.pq, 0.0, 1.0);
 
   // xNg
   //   position ɃXN[̑傫 screen.st ĒSʒu screen.pq 𑫂΁A
   //   XN[̓_̈ʒu p 邩A_ɂ鎋_炱̓_Ɍ́A
   //   œ_ focal  Z Wɗp (p, -focal) ƂȂB
+  //   ~}@ŕ`Ƃ position ̌oxƈܓx̕ɂB
   //   ]āA̎̕PʃxNg𓾂B
-  vec2 p = position * screen.st + screen.pq;
-  vector = rotation * vec4(p, -focal, 0.0);
+  vec2 p = position * current.screen.st + current.screen.pq;
+  vector = current.rotation * (projection == 1 ? longitudeLatitude(position) : vec4(p, -current.focal, 0.0));
 }
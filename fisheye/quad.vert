@@ -0,0 +1,17 @@
+#version 150 core
+
+//
+// NbsOԑSʂ𕢂lp`
+//
+
+// NbsOԏ̈ʒu
+out vec2 position;
+
+void main(void)
+{
+  // _ʒu
+  //   gl_VertexID  0, 1, 2, 3 ̂Ƃ (-1, -1), (1, -1), (-1, 1), (1, 1) ɂȂ邩A
+  //    GL_TRIANGLE_STRIP ŕ`΃NbsOԑSʂ𕢂B
+  position = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+  gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,93 @@
+#version 150 core
+#extension GL_ARB_explicit_attrib_location : enable
+
+//
+// WJ̉fƂɔwieNX`̃eNX`W߂ĎQƕ\Ɋi[
+//
+
+// WJɎgVF[_̓ẽf (ViewTiles::Model)
+//   1: fixed.vert, 2: rectangle.vert, 3: fisheye.vert, 4: theta.vert, 5: panorama.vert
+uniform int model;
+
+// XN[̑傫ƒSʒu
+uniform vec4 screen;
+
+// XN[܂ł̏œ_
+uniform float focal;
+
+// XN[]ϊs
+uniform mat4 rotation;
+
+// wieNX`̔aƒSʒu
+uniform vec4 circle;
+
+// wieNX`ɐ؂ot[͈̔ (t[ɑ΂鍶̈ʒuƑ傫)
+uniform vec4 crop;
+
+// wieNX`Ŝ̑傫
+uniform ivec2 extent;
+
+// NbsOԏ̈ʒu
+in vec2 position;
+
+// eNX`W (theta.vert ł͌ƑÕY̓g)
+layout (location = 0) out vec4 texcoord;
+
+// ÕeNX`̍
+layout (location = 1) out float blend;
+
+void main(void)
+{
+  // XN[̓_ƂɌ
+  //   ꂼ̃VF[__ŋ߂lfƂɋ߂B
+  vec2 p = position * screen.st + screen.pq;
+  vec4 vector = rotation * vec4(p, -focal, 0.0);
+  vec2 size = vec2(extent);
+  blend = 0.0;
+  texcoord = vec4(0.0);
+
+  if (model == 1)
+  {
+    // fixed.vert: ]Ȃ
+    vec2 scale = vec2(0.5 * size.y / size.x, -0.5) / circle.st;
+    texcoord.st = p * scale + circle.pq + 0.5;
+  }
+  else if (model == 2)
+  {
+    // rectangle.vert: 摜ʂւ̓e
+    vec2 scale = vec2(-0.5 * size.y / size.x, 0.5) / circle.st;
+    vector = normalize(vector);
+    texcoord.st = vector.xy * scale / vector.z + circle.pq + 0.5;
+  }
+  else if (model == 3)
+  {
+    // fisheye.vert: ˉe (؂o͈͂̃eNX`Ԃɍ킹)
+    size /= crop.pq;
+    vec2 scale = vec2(0.5 * size.y / size.x, -0.5) / circle.st / crop.pq;
+    vec2 center = (circle.pq + 0.5 - crop.st) / crop.pq;
+    vector = normalize(vector);
+    texcoord.st = acos(-vector.z) * normalize(vector.xy) * scale + center;
+  }
+  else if (model == 4)
+  {
+    // theta.vert: ƑÕY̑
+    vec2 radius_b = circle.st * vec2(-0.25, 0.25 * size.x / size.y);
+    vec2 center_b = vec2(radius_b.s - circle.p + 0.5, radius_b.t - circle.q);
+    vec2 radius_f = vec2(-radius_b.s, radius_b.t);
+    vec2 center_f = vec2(center_b.s + 0.5, center_b.t);
+    vector = normalize(vector);
+    float angle = 1.0 - acos(vector.z) * 0.63661977;
+    blend = smoothstep(-0.02, 0.02, angle);
+    vec2 orientation = normalize(vector.yx) * 0.885;
+    texcoord.st = (1.0 - angle) * orientation * radius_b + center_b;
+    texcoord.pq = (1.0 + angle) * orientation * radius_f + center_f;
+  }
+  else if (model == 5)
+  {
+    // panorama.frag: ~}@
+    vec4 orientation = normalize(vector);
+    vec2 u = orientation.xy;
+    vec2 v = vec2(orientation.z, length(orientation.xz));
+    texcoord.st = atan(u, v) * vec2(-0.15915494, -0.31830989) / circle.st + circle.pq + 0.5;
+  }
+}
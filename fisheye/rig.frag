@@ -0,0 +1,87 @@
+#version 150 core
+#extension GL_ARB_explicit_attrib_location : enable
+
+//
+// WJ̉fƂɕ̃YgIсÃeNX`WƍQƕ\Ɋi[
+//
+
+// XN[̑傫ƒSʒu
+uniform vec4 screen;
+
+// XN[܂ł̏œ_
+uniform float focal;
+
+// XN[]ϊs
+uniform mat4 rotation;
+
+// ȂY̐
+uniform int lenses;
+
+// Y̍WnɈڂ]s (Rig.h)
+uniform mat3 pose[8];
+
+// ̊px̃eNX`W̕ωƌ̈ʒũeNX`W
+uniform vec4 projection[8];
+
+// g̊px̏ƂȂڂŗׂ̃Yƍ镝
+uniform vec2 field[8];
+
+// NbsOԏ̈ʒu
+in vec2 position;
+
+// ܂ޓ̃ỸeNX`W (pq ԖځAst Ԗ)
+layout (location = 0) out vec4 texcoord;
+
+// Ԗڂ̃Y̍
+layout (location = 1) out float blend;
+
+// ԖڂƓԖڂ̃Y̔ԍ (YƂ̃J̃eNX`z̃C[)
+layout (location = 2) out uvec2 lens;
+
+void main(void)
+{
+  // XN[̓_Ɍ
+  vec2 p = position * screen.st + screen.pq;
+  vec3 vector = normalize((rotation * vec4(p, -focal, 0.0)).xyz);
+
+  // g͈͂̓ɂǂꂾĂ邩 (px̗]T) ̑傫̃Y
+  //   ǂ̃YɂʂĂȂ΃eNX`̊OwčB
+  vec2 margin = vec2(-1.0);
+  ivec2 index = ivec2(-1);
+  vec4 tc = vec4(-1.0);
+
+  for (int i = 0; i < lenses; ++i)
+  {
+    // Y̍Wn̎ƌ (-z ) ̊px
+    vec3 l = pose[i] * vector;
+    float theta = acos(clamp(-l.z, -1.0, 1.0));
+
+    // g͈͂̊OAłɎcĂ]TΎgȂ
+    float m = field[i].x - theta;
+    if (m < 0.0 || m <= margin.y) continue;
+
+    // ˉẽeNX`W
+    float r = length(l.xy);
+    vec2 t = (r > 0.0 ? theta / r * l.xy : vec2(0.0)) * projection[i].xy + projection[i].zw;
+
+    // ]T̑傫قc
+    if (m > margin.x)
+    {
+      margin = vec2(m, margin.x);
+      index = ivec2(i, index.x);
+      tc = vec4(tc.pq, t);
+    }
+    else
+    {
+      margin.y = m;
+      index.y = i;
+      tc.st = t;
+    }
+  }
+
+  // Ȃڂ͓̃Y̗]TƂŁȂO̕ō
+  //   p̓Ył͓̌瓙pẍʒuȂڂɂȂB
+  texcoord = tc;
+  lens = uvec2(max(index, 0));
+  blend = index.y < 0 ? 0.0 : smoothstep(-0.5, 0.5, (margin.y - margin.x) / field[index.x].y);
+}
@@ -1,13 +1,8 @@
-#version 150 core
-#extension GL_ARB_explicit_attrib_location : enable
-
 //
 //   RICOH THETA S ̃CuXg[~Of̕ʓWJ
+//   wieNX`TvO֐ background.glsl ɂB
 //
 
-// wieNX`
-uniform sampler2D image;
-
 // eNX`W
 in vec2 texcoord_b;
 in vec2 texcoord_f;
@@ -21,8 +16,8 @@ layout (location = 0) out vec4 fc;
 void main(void)
 {
   // ÕeNX`̐FTvO
-  vec4 color_b = texture(image, texcoord_b);
-  vec4 color_f = texture(image, texcoord_f);
+  vec4 color_b = background(texcoord_b);
+  vec4 color_f = background(texcoord_f);
 
   // TvOFuhătOg̐F߂
   fc = mix(color_f, color_b, blend);